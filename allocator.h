@@ -0,0 +1,266 @@
+#ifndef LAZPERF_C_ALLOCATOR_H
+#define LAZPERF_C_ALLOCATOR_H
+
+#include "lazperf_c.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+struct AllocatorHooks
+{
+	LazPerf_MallocFn malloc;
+	LazPerf_ReallocFn realloc;
+	LazPerf_FreeFn free;
+	void *ctx;
+};
+
+inline void *defaultMalloc(void *, size_t size)
+{ return std::malloc(size); }
+
+inline void *defaultRealloc(void *, void *ptr, size_t size)
+{ return std::realloc(ptr, size); }
+
+inline void defaultFree(void *, void *ptr)
+{ std::free(ptr); }
+
+/**
+ * The allocator used for the memory owned by the library, set by 'lazperf_set_allocator'
+ */
+inline AllocatorHooks &allocatorHooks()
+{
+	static AllocatorHooks hooks = {defaultMalloc, defaultRealloc, defaultFree, nullptr};
+	return hooks;
+}
+
+/**
+ * Allocates 'size' bytes with the user allocator, throws std::bad_alloc if it fails
+ */
+inline void *lazperfMalloc(size_t size)
+{
+	const AllocatorHooks &hooks = allocatorHooks();
+	// Never ask for 0 bytes, as malloc(0) may legitimately return NULL
+	void *ptr = hooks.malloc(hooks.ctx, size == 0 ? 1 : size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+inline void *lazperfRealloc(void *ptr, size_t size)
+{
+	const AllocatorHooks &hooks = allocatorHooks();
+	void *newPtr = hooks.realloc(hooks.ctx, ptr, size == 0 ? 1 : size);
+	if (!newPtr)
+	{
+		throw std::bad_alloc();
+	}
+	return newPtr;
+}
+
+inline void lazperfFree(void *ptr)
+{
+	if (ptr)
+	{
+		const AllocatorHooks &hooks = allocatorHooks();
+		hooks.free(hooks.ctx, ptr);
+	}
+}
+
+/**
+ * Like strdup, but with the user allocator. Returns NULL if the allocation fails, as it is used to report errors.
+ */
+inline char *lazperfStrdup(const char *str)
+{
+	const AllocatorHooks &hooks = allocatorHooks();
+	size_t size = std::strlen(str) + 1;
+	auto copy = static_cast<char *>(hooks.malloc(hooks.ctx, size));
+	if (copy)
+	{
+		std::memcpy(copy, str, size);
+	}
+	return copy;
+}
+
+/**
+ * Allocates an (uninitialized) array of 'count' trivial T with the user allocator
+ */
+template<typename T>
+inline T *lazperfAllocArray(size_t count)
+{
+	if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+	{
+		throw std::bad_alloc();
+	}
+	return static_cast<T *>(lazperfMalloc(count * sizeof(T)));
+}
+
+struct LazPerfDeleter
+{
+	void operator()(void *ptr) const
+	{ lazperfFree(ptr); }
+};
+
+/**
+ * Owns an array allocated by 'lazperfAllocArray', until it is released to the caller of the C API
+ */
+template<typename T>
+using LazPerfArray = std::unique_ptr<T[], LazPerfDeleter>;
+
+
+/**
+ * Standard allocator going through the user allocator, for the large internal buffers
+ */
+template<typename T>
+class LazPerfAllocator
+{
+public:
+	typedef T value_type;
+
+	LazPerfAllocator() = default;
+
+	template<typename U>
+	LazPerfAllocator(const LazPerfAllocator<U> &)
+	{}
+
+	T *allocate(size_t count)
+	{ return lazperfAllocArray<T>(count); }
+
+	void deallocate(T *ptr, size_t)
+	{ lazperfFree(ptr); }
+};
+
+template<typename T, typename U>
+inline bool operator==(const LazPerfAllocator<T> &, const LazPerfAllocator<U> &)
+{ return true; }
+
+template<typename T, typename U>
+inline bool operator!=(const LazPerfAllocator<T> &, const LazPerfAllocator<U> &)
+{ return false; }
+
+typedef std::vector<uint8_t, LazPerfAllocator<uint8_t>> ByteBuffer;
+
+
+/**
+ * Buffer handed to the user once filled, it grows with the user realloc,
+ * so that it does not have to be copied into a buffer of the exact size at the end.
+ */
+class ResultBuffer
+{
+public:
+	ResultBuffer() : m_data(nullptr), m_size(0), m_capacity(0)
+	{}
+
+	~ResultBuffer()
+	{ lazperfFree(m_data); }
+
+	ResultBuffer(const ResultBuffer &) = delete;
+
+	ResultBuffer &operator=(const ResultBuffer &) = delete;
+
+	size_t size() const
+	{ return m_size; }
+
+	/**
+	 * Adds 'count' bytes at the end of the buffer and returns where they start
+	 */
+	char *grow(size_t count)
+	{
+		if (count > m_capacity - m_size)
+		{
+			size_t capacity = std::max(m_size + count, m_capacity * 2);
+			m_data = static_cast<char *>(lazperfRealloc(m_data, capacity));
+			m_capacity = capacity;
+		}
+		char *start = m_data + m_size;
+		m_size += count;
+		return start;
+	}
+
+	void append(const char *data, size_t count)
+	{
+		std::memcpy(grow(count), data, count);
+	}
+
+	/**
+	 * Gives the ownership of the bytes to the caller, who frees them with 'lazperfFree'
+	 */
+	LazPerf_SizedBuffer release()
+	{
+		LazPerf_SizedBuffer buffer{};
+		buffer.data = m_data ? m_data : lazperfAllocArray<char>(0);
+		buffer.size = m_size;
+		m_data = nullptr;
+		m_size = 0;
+		m_capacity = 0;
+		return buffer;
+	}
+
+private:
+	char *m_data;
+	size_t m_size;
+	size_t m_capacity;
+};
+
+
+/**
+ * Storage for an object that is rebuilt in place from time to time, without going through the heap
+ */
+template<typename T>
+class InPlace
+{
+public:
+	InPlace() : m_constructed(false)
+	{}
+
+	~InPlace()
+	{ reset(); }
+
+	InPlace(const InPlace &) = delete;
+
+	InPlace &operator=(const InPlace &) = delete;
+
+	/**
+	 * Destroys the current object, if any, and constructs a new one from 'args'
+	 */
+	template<typename... Args>
+	T &emplace(Args &&... args)
+	{
+		reset();
+		new(&m_storage) T(std::forward<Args>(args)...);
+		m_constructed = true;
+		return **this;
+	}
+
+	void reset()
+	{
+		if (m_constructed)
+		{
+			(**this).~T();
+			m_constructed = false;
+		}
+	}
+
+	T &operator*()
+	{ return *reinterpret_cast<T *>(&m_storage); }
+
+	T *operator->()
+	{ return reinterpret_cast<T *>(&m_storage); }
+
+	explicit operator bool() const
+	{ return m_constructed; }
+
+private:
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+	bool m_constructed;
+};
+
+#endif //LAZPERF_C_ALLOCATOR_H
@@ -0,0 +1,138 @@
+#ifndef LAZPERF_C_BATCH_H
+#define LAZPERF_C_BATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/**
+ * One chunk of one of the jobs of a batch, the unit of work handed out to the threads
+ */
+struct BatchTask
+{
+	size_t job;
+	size_t chunk;
+	/* estimated cost, the number of uncompressed bytes of the chunk */
+	uint64_t cost;
+};
+
+/**
+ * Orders the tasks from the most to the least expensive.
+ *
+ * The chunks of the largest jobs are started first and the small ones fill the gaps at the end,
+ * so that a single large job does not end up running alone on one thread.
+ */
+inline void sortTasksByCost(std::vector<BatchTask> &tasks)
+{
+	std::stable_sort(tasks.begin(), tasks.end(), [](const BatchTask &lhs, const BatchTask &rhs)
+	{
+		return lhs.cost > rhs.cost;
+	});
+}
+
+
+/**
+ * Errors of the jobs of a batch.
+ *
+ * A job fails with the first error thrown by any of its tasks, its remaining tasks are skipped
+ * while the other jobs carry on.
+ */
+class BatchErrors
+{
+public:
+	explicit BatchErrors(size_t numJobs)
+			: m_numJobs(numJobs), m_failed(new std::atomic<bool>[numJobs]), m_messages(numJobs), m_numFailed(0)
+	{
+		for (size_t i = 0; i < numJobs; ++i)
+		{
+			m_failed[i] = false;
+		}
+	}
+
+	bool failed(size_t job) const
+	{ return m_failed[job]; }
+
+	const std::string &message(size_t job) const
+	{ return m_messages[job]; }
+
+	/**
+	 * Calls 'fn' unless the job already failed, and records what it throws as the error of the job
+	 */
+	template<typename Fn>
+	void run(size_t job, Fn fn)
+	{
+		if (failed(job))
+		{
+			return;
+		}
+		try
+		{
+			fn();
+		}
+		catch (const std::exception &e)
+		{
+			fail(job, e.what());
+		}
+		catch (...)
+		{
+			fail(job, "Unknown error");
+		}
+	}
+
+	void fail(size_t job, const char *message)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_failed[job])
+		{
+			m_messages[job] = message;
+			m_failed[job] = true;
+			m_numFailed++;
+		}
+	}
+
+	/**
+	 * Fails all the jobs that did not fail yet, for errors that are not tied to a job
+	 */
+	void failRemaining(const char *message)
+	{
+		for (size_t i = 0; i < m_numJobs; ++i)
+		{
+			fail(i, message);
+		}
+	}
+
+	/**
+	 * Throws an error summarizing the failed jobs, if any
+	 */
+	void check() const
+	{
+		if (m_numFailed == 0)
+		{
+			return;
+		}
+		size_t first = 0;
+		while (!m_failed[first])
+		{
+			first++;
+		}
+		throw std::runtime_error(
+				std::to_string(m_numFailed) + " of " + std::to_string(m_numJobs) + " jobs failed, job "
+				+ std::to_string(first) + ": " + m_messages[first]);
+	}
+
+private:
+	size_t m_numJobs;
+	std::unique_ptr<std::atomic<bool>[]> m_failed;
+	std::vector<std::string> m_messages;
+	size_t m_numFailed;
+	std::mutex m_mutex;
+};
+
+#endif //LAZPERF_C_BATCH_H
@@ -0,0 +1,462 @@
+/*
+ * Throughput benchmark of the compression and decompression paths.
+ *
+ * Points are generated deterministically (same seed, same points on every run and machine),
+ * for every combination of record items, at several point densities, noise levels and chunk sizes.
+ *
+ * Usage: bench-lazperf [num_points] [repetitions] [num_threads]
+ *
+ * The results are written to stdout as CSV, one line per configuration and path,
+ * with the best time of the repetitions, so that the outputs of two versions can be diffed.
+ */
+#include <lazperf_c.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_NUM_POINTS 1000000
+#define DEFAULT_REPETITIONS 3
+#define DEFAULT_CHUNK_SIZE 50000
+#define EXTRA_BYTES_COUNT 4
+#define STREAMING_BLOCK_POINTS 1000
+#define STREAMING_READ_SIZE (64 * 1024)
+
+/* Record items, combined as bit flags, the point item is always there */
+#define ITEM_GPSTIME 1
+#define ITEM_RGB 2
+#define ITEM_EXTRABYTES 4
+#define NUM_ITEM_COMBINATIONS 8
+
+struct Density
+{
+	const char *name;
+	/* Distance between two points of a scan line, in units of the coordinates */
+	int32_t spacing;
+};
+
+struct Noise
+{
+	const char *name;
+	/* Amplitude of the random variations of Z, intensity and colors */
+	int32_t amplitude;
+};
+
+static const struct Density DENSITIES[] = {{"dense", 1}, {"sparse", 50}};
+static const struct Noise NOISES[] = {{"smooth", 0}, {"noisy", 200}};
+static const uint32_t CHUNK_SIZES[] = {5000, DEFAULT_CHUNK_SIZE, 250000};
+
+#define COUNT_OF(array) (sizeof(array) / sizeof((array)[0]))
+
+
+/* Deterministic random numbers (xorshift64*) */
+
+static uint64_t rng_next(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+static int32_t rng_range(uint64_t *state, int32_t amplitude)
+{
+	if (amplitude == 0)
+	{
+		return 0;
+	}
+	return (int32_t) (rng_next(state) % (uint64_t) (2 * amplitude + 1)) - amplitude;
+}
+
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static size_t point_size_of(int items)
+{
+	size_t size = 20;
+	if (items & ITEM_GPSTIME)
+	{
+		size += 8;
+	}
+	if (items & ITEM_RGB)
+	{
+		size += 6;
+	}
+	if (items & ITEM_EXTRABYTES)
+	{
+		size += EXTRA_BYTES_COUNT;
+	}
+	return size;
+}
+
+static void schema_name(int items, char *out, size_t out_size)
+{
+	snprintf(out, out_size, "point%s%s%s",
+			 (items & ITEM_GPSTIME) ? "+gpstime" : "",
+			 (items & ITEM_RGB) ? "+rgb" : "",
+			 (items & ITEM_EXTRABYTES) ? "+extrabytes" : "");
+}
+
+static LazPerf_RecordSchemaPtr new_schema(int items)
+{
+	LazPerf_RecordSchemaPtr schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(schema);
+	if (items & ITEM_GPSTIME)
+	{
+		lazperf_record_schema_push_gpstime(schema);
+	}
+	if (items & ITEM_RGB)
+	{
+		lazperf_record_schema_push_rgb(schema);
+	}
+	if (items & ITEM_EXTRABYTES)
+	{
+		lazperf_record_schema_push_extrabytes(schema, EXTRA_BYTES_COUNT);
+	}
+	return schema;
+}
+
+/**
+ * Generates points looking like an airborne scan: lines of points going back and forth,
+ * over a gently sloping terrain, with the first, second... returns of the pulses.
+ */
+static char *generate_points(int items, size_t num_points, const struct Density *density, const struct Noise *noise)
+{
+	const int32_t points_per_line = 2000;
+	size_t point_size = point_size_of(items);
+	char *points = malloc(num_points * point_size);
+	uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+	char *point = points;
+	for (size_t i = 0; i < num_points; ++i, point += point_size)
+	{
+		int32_t line = (int32_t) (i / points_per_line);
+		int32_t column = (int32_t) (i % points_per_line);
+		if (line % 2 == 1)
+		{
+			column = points_per_line - 1 - column;
+		}
+		int32_t x = column * density->spacing + rng_range(&rng, density->spacing / 4);
+		int32_t y = line * density->spacing + rng_range(&rng, density->spacing / 4);
+		int32_t z = 10000 + x / 8 + y / 16 + rng_range(&rng, noise->amplitude);
+		uint16_t intensity = (uint16_t) (1000 + (x + y) % 500 + rng_range(&rng, noise->amplitude));
+		uint8_t number_of_returns = (uint8_t) (1 + (i / 7) % 3);
+		uint8_t return_number = (uint8_t) (1 + i % number_of_returns);
+		uint8_t flags = (uint8_t) (return_number | (number_of_returns << 3) | ((line % 2) << 6));
+		uint8_t classification = (uint8_t) (return_number == number_of_returns ? 2 : 5);
+		int8_t scan_angle = (int8_t) (column * 40 / points_per_line - 20);
+		uint8_t user_data = 0;
+		uint16_t point_source_id = (uint16_t) (1 + line / 100);
+
+		memcpy(point, &x, 4);
+		memcpy(point + 4, &y, 4);
+		memcpy(point + 8, &z, 4);
+		memcpy(point + 12, &intensity, 2);
+		point[14] = (char) flags;
+		point[15] = (char) classification;
+		point[16] = (char) scan_angle;
+		point[17] = (char) user_data;
+		memcpy(point + 18, &point_source_id, 2);
+
+		size_t offset = 20;
+		if (items & ITEM_GPSTIME)
+		{
+			double gps_time = 300000.0 + (double) i * 1e-5;
+			memcpy(point + offset, &gps_time, 8);
+			offset += 8;
+		}
+		if (items & ITEM_RGB)
+		{
+			uint16_t rgb[3];
+			rgb[0] = (uint16_t) ((classification == 2 ? 30000 : 12000) + rng_range(&rng, noise->amplitude * 10));
+			rgb[1] = (uint16_t) ((classification == 2 ? 25000 : 40000) + rng_range(&rng, noise->amplitude * 10));
+			rgb[2] = (uint16_t) (20000 + rng_range(&rng, noise->amplitude * 10));
+			memcpy(point + offset, rgb, 6);
+			offset += 6;
+		}
+		if (items & ITEM_EXTRABYTES)
+		{
+			uint16_t extra[2] = {(uint16_t) (z / 10), (uint16_t) (rng_next(&rng) & 0xFF)};
+			memcpy(point + offset, extra, EXTRA_BYTES_COUNT);
+		}
+	}
+	return points;
+}
+
+
+struct Config
+{
+	char schema[64];
+	const struct Density *density;
+	const struct Noise *noise;
+	uint32_t chunk_size;
+	size_t num_points;
+	size_t point_size;
+};
+
+static void print_header(void)
+{
+	printf("schema,density,noise,chunk_size,path,points,raw_bytes,compressed_bytes,seconds,points_per_s,mb_per_s\n");
+}
+
+/**
+ * The throughput in MB/s is the one of the uncompressed points, for both directions
+ */
+static void print_result(const struct Config *config, const char *path, size_t compressed_size, double seconds)
+{
+	size_t raw_size = config->num_points * config->point_size;
+	printf("%s,%s,%s,%u,%s,%zu,%zu,%zu,%.6f,%.0f,%.2f\n",
+		   config->schema, config->density->name, config->noise->name, config->chunk_size, path,
+		   config->num_points, raw_size, compressed_size, seconds,
+		   (double) config->num_points / seconds, (double) raw_size / seconds / 1e6);
+	fflush(stdout);
+}
+
+static void check_result(struct LazPerf_VoidResult result, const char *what)
+{
+	if (result.is_error)
+	{
+		fprintf(stderr, "%s failed: %s\n", what, result.error.error_msg);
+		lazperf_delete_void_result(&result);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void check_size_result(struct LazPerf_SizeResult result, const char *what)
+{
+	if (result.is_error)
+	{
+		fprintf(stderr, "%s failed: %s\n", what, result.error.error_msg);
+		lazperf_delete_size_result(&result);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void check_buffer_result(struct LazPerf_BufferResult *result, const char *what)
+{
+	if (result->is_error)
+	{
+		fprintf(stderr, "%s failed: %s\n", what, result->error.error_msg);
+		lazperf_delete_result(result);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void check_points(const char *expected, const char *actual, const struct Config *config, const char *path)
+{
+	if (memcmp(expected, actual, config->num_points * config->point_size) != 0)
+	{
+		fprintf(stderr, "%s: decompressed points differ from the original ones (%s)\n", path, config->schema);
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/**
+ * Memory read by the read callback of the streaming decompression
+ */
+struct MemorySource
+{
+	const uint8_t *data;
+	size_t size;
+	size_t position;
+};
+
+static size_t read_memory(void *user_data, uint8_t *buffer, size_t size)
+{
+	struct MemorySource *source = user_data;
+	size_t count = source->size - source->position;
+	if (count > size)
+	{
+		count = size;
+	}
+	memcpy(buffer, source->data + source->position, count);
+	source->position += count;
+	return count;
+}
+
+
+/**
+ * Compresses with the streaming compressor (the only one with a configurable chunk size)
+ * and benchmarks the decompression paths on its output.
+ */
+static void bench_chunked_paths(
+		const struct Config *config,
+		LazPerf_RecordSchemaPtr schema,
+		const char *points,
+		char *decompressed,
+		int repetitions,
+		size_t num_threads)
+{
+	LazPerf_VlrCompressorPtr compressor = NULL;
+	uint64_t chunk_table_offset = 0;
+	double best = 0;
+	for (int r = 0; r < repetitions; ++r)
+	{
+		if (compressor)
+		{
+			lazperf_delete_vlr_compressor(compressor);
+		}
+		double start = now_seconds();
+		compressor = lazperf_new_vlr_compressor(schema);
+		check_result(lazperf_vlr_compressor_set_chunk_size(compressor, config->chunk_size), "set_chunk_size");
+		for (size_t i = 0; i < config->num_points; i += STREAMING_BLOCK_POINTS)
+		{
+			size_t count = config->num_points - i < STREAMING_BLOCK_POINTS ? config->num_points - i
+																		  : STREAMING_BLOCK_POINTS;
+			check_size_result(lazperf_vlr_compressor_compress_many(
+					compressor, count, points + i * config->point_size), "compress_many");
+		}
+		chunk_table_offset = lazperf_vlr_compressor_done(compressor) - 8;
+		lazperf_vlr_compressor_write_chunk_table(compressor);
+		double elapsed = now_seconds() - start;
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+
+	const uint8_t *compressed = lazperf_vlr_compressor_internal_buffer(compressor) + 8;
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor) - 8;
+	struct LazPerf_SizedBuffer vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+	print_result(config, "compress_streaming", compressed_size + 8, best);
+
+	for (int r = 0; r < repetitions; ++r)
+	{
+		memset(decompressed, 0, config->num_points * config->point_size);
+		double start = now_seconds();
+		LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+				compressed, compressed_size, config->point_size, vlr_data.data);
+		check_result(lazperf_vlr_decompressor_decompress_many(decompressor, config->num_points, decompressed),
+					 "decompress_many");
+		lazperf_delete_vlr_decompressor(decompressor);
+		double elapsed = now_seconds() - start;
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+	check_points(points, decompressed, config, "decompress_batch");
+	print_result(config, "decompress_batch", compressed_size + 8, best);
+
+	for (int r = 0; r < repetitions; ++r)
+	{
+		memset(decompressed, 0, config->num_points * config->point_size);
+		struct MemorySource source = {compressed, chunk_table_offset, 0};
+		double start = now_seconds();
+		LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor_from_source(
+				read_memory, &source, STREAMING_READ_SIZE, config->point_size, vlr_data.data);
+		for (size_t i = 0; i < config->num_points; i += STREAMING_BLOCK_POINTS)
+		{
+			size_t count = config->num_points - i < STREAMING_BLOCK_POINTS ? config->num_points - i
+																		  : STREAMING_BLOCK_POINTS;
+			check_result(lazperf_vlr_decompressor_decompress_many(
+					decompressor, count, decompressed + i * config->point_size), "decompress_many");
+		}
+		lazperf_delete_vlr_decompressor(decompressor);
+		double elapsed = now_seconds() - start;
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+	check_points(points, decompressed, config, "decompress_streaming");
+	print_result(config, "decompress_streaming", compressed_size + 8, best);
+
+	for (int r = 0; r < repetitions; ++r)
+	{
+		memset(decompressed, 0, config->num_points * config->point_size);
+		double start = now_seconds();
+		check_result(lazperf_decompress_points_parallel(
+				compressed, compressed_size, chunk_table_offset, vlr_data.data, config->num_points,
+				config->point_size, (uint8_t *) decompressed, num_threads), "decompress_points_parallel");
+		double elapsed = now_seconds() - start;
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+	check_points(points, decompressed, config, "decompress_parallel");
+	print_result(config, "decompress_parallel", compressed_size + 8, best);
+
+	lazperf_delete_sized_buffer(vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+}
+
+/**
+ * Benchmarks the one-shot compression functions, which always use the default chunk size
+ */
+static void bench_one_shot_compression(
+		const struct Config *config,
+		LazPerf_RecordSchemaPtr schema,
+		const char *points,
+		int repetitions,
+		size_t num_threads)
+{
+	double best = 0;
+	size_t compressed_size = 0;
+	for (int r = 0; r < repetitions; ++r)
+	{
+		double start = now_seconds();
+		struct LazPerf_BufferResult result = lazperf_compress_points(schema, 0, points, config->num_points);
+		double elapsed = now_seconds() - start;
+		check_buffer_result(&result, "compress_points");
+		compressed_size = result.points_buffer.size;
+		lazperf_delete_result(&result);
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+	print_result(config, "compress_batch", compressed_size, best);
+
+	for (int r = 0; r < repetitions; ++r)
+	{
+		double start = now_seconds();
+		struct LazPerf_BufferResult result = lazperf_compress_points_parallel(
+				schema, 0, points, config->num_points, config->chunk_size, num_threads);
+		double elapsed = now_seconds() - start;
+		check_buffer_result(&result, "compress_points_parallel");
+		compressed_size = result.points_buffer.size;
+		lazperf_delete_result(&result);
+		best = (r == 0 || elapsed < best) ? elapsed : best;
+	}
+	print_result(config, "compress_parallel", compressed_size, best);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t num_points = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : DEFAULT_NUM_POINTS;
+	int repetitions = argc > 2 ? atoi(argv[2]) : DEFAULT_REPETITIONS;
+	size_t num_threads = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : 0;
+	if (num_points == 0 || repetitions <= 0)
+	{
+		fprintf(stderr, "Usage: %s [num_points] [repetitions] [num_threads]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	print_header();
+	for (int items = 0; items < NUM_ITEM_COMBINATIONS; ++items)
+	{
+		LazPerf_RecordSchemaPtr schema = new_schema(items);
+		for (size_t d = 0; d < COUNT_OF(DENSITIES); ++d)
+		{
+			for (size_t n = 0; n < COUNT_OF(NOISES); ++n)
+			{
+				struct Config config;
+				schema_name(items, config.schema, sizeof(config.schema));
+				config.density = &DENSITIES[d];
+				config.noise = &NOISES[n];
+				config.num_points = num_points;
+				config.point_size = point_size_of(items);
+
+				char *points = generate_points(items, num_points, config.density, config.noise);
+				char *decompressed = malloc(num_points * config.point_size);
+				for (size_t c = 0; c < COUNT_OF(CHUNK_SIZES); ++c)
+				{
+					config.chunk_size = CHUNK_SIZES[c];
+					if (config.chunk_size == DEFAULT_CHUNK_SIZE)
+					{
+						bench_one_shot_compression(&config, schema, points, repetitions, num_threads);
+					}
+					bench_chunked_paths(&config, schema, points, decompressed, repetitions, num_threads);
+				}
+				free(decompressed);
+				free(points);
+			}
+		}
+		lazperf_delete_record_schema(schema);
+	}
+	return EXIT_SUCCESS;
+}
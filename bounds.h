@@ -0,0 +1,80 @@
+#ifndef LAZPERF_C_BOUNDS_H
+#define LAZPERF_C_BOUNDS_H
+
+#include "lazperf_c.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * Returns bounds that contain nothing, and that 'expandBounds' can grow
+ */
+inline LazPerf_Bounds emptyBounds()
+{
+	LazPerf_Bounds bounds{};
+	std::fill(std::begin(bounds.mins), std::end(bounds.mins), INT32_MAX);
+	std::fill(std::begin(bounds.maxs), std::end(bounds.maxs), INT32_MIN);
+	return bounds;
+}
+
+/**
+ * Grows the bounds to contain the 'count' points, X, Y and Z being the first 3 int32 of each point
+ */
+inline void expandBounds(LazPerf_Bounds &bounds, const uint8_t *points, size_t count, size_t pointSize)
+{
+	for (size_t i = 0; i < count; ++i, points += pointSize)
+	{
+		for (size_t j = 0; j < 3; ++j)
+		{
+			int32_t value;
+			std::memcpy(&value, points + 4 * j, sizeof(int32_t));
+			bounds.mins[j] = std::min(bounds.mins[j], value);
+			bounds.maxs[j] = std::max(bounds.maxs[j], value);
+		}
+	}
+}
+
+inline bool boundsIntersect(const LazPerf_Bounds &a, const LazPerf_Bounds &b)
+{
+	for (size_t j = 0; j < 3; ++j)
+	{
+		if (a.mins[j] > b.maxs[j] || a.maxs[j] < b.mins[j])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns whether 'inner' is entirely inside 'outer'
+ */
+inline bool boundsContain(const LazPerf_Bounds &outer, const LazPerf_Bounds &inner)
+{
+	for (size_t j = 0; j < 3; ++j)
+	{
+		if (inner.mins[j] < outer.mins[j] || inner.maxs[j] > outer.maxs[j])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool pointInBounds(const LazPerf_Bounds &bounds, const uint8_t *point)
+{
+	for (size_t j = 0; j < 3; ++j)
+	{
+		int32_t value;
+		std::memcpy(&value, point + 4 * j, sizeof(int32_t));
+		if (value < bounds.mins[j] || value > bounds.maxs[j])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+#endif //LAZPERF_C_BOUNDS_H
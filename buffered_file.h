@@ -0,0 +1,167 @@
+#ifndef LAZPERF_C_BUFFERED_FILE_H
+#define LAZPERF_C_BUFFERED_FILE_H
+
+#include "allocator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Output file with a large aligned write buffer.
+ *
+ * Data is only written to the file in blocks of the buffer's size (except when flushing),
+ * and bytes already written can be overwritten in place with 'pwrite'.
+ */
+class BufferedFile
+{
+public:
+	static const size_t DefaultBufferSize = 1 << 20;
+	static const size_t BufferAlignment = 4096;
+
+	explicit BufferedFile(const char *path, size_t bufferSize = DefaultBufferSize)
+			: m_fd(-1), m_storage(lazperfAllocArray<uint8_t>(bufferSize + BufferAlignment)), m_buffer(nullptr),
+			  m_bufferSize(bufferSize), m_used(0), m_written(0)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.get());
+		m_buffer = m_storage.get() + (BufferAlignment - address % BufferAlignment) % BufferAlignment;
+#ifdef _WIN32
+		m_fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		m_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+		if (m_fd == -1)
+		{
+			throw std::runtime_error(std::string("Failed to create ") + path + ": " + std::strerror(errno));
+		}
+	}
+
+	~BufferedFile()
+	{
+		if (m_fd != -1)
+		{
+#ifdef _WIN32
+			_close(m_fd);
+#else
+			::close(m_fd);
+#endif
+		}
+	}
+
+	BufferedFile(const BufferedFile &) = delete;
+
+	BufferedFile &operator=(const BufferedFile &) = delete;
+
+	void write(const uint8_t *data, size_t size)
+	{
+		while (size > 0)
+		{
+			size_t count = std::min(size, m_bufferSize - m_used);
+			std::memcpy(m_buffer + m_used, data, count);
+			m_used += count;
+			data += count;
+			size -= count;
+			if (m_used == m_bufferSize)
+			{
+				flush();
+			}
+		}
+	}
+
+	/**
+	 * Writes the buffered data to the file
+	 */
+	void flush()
+	{
+		writeAt(m_written, m_buffer, m_used);
+		m_written += m_used;
+		m_used = 0;
+	}
+
+	/**
+	 * Overwrites bytes at 'offset', the bytes must already be flushed to the file
+	 */
+	void pwrite(uint64_t offset, const uint8_t *data, size_t size)
+	{
+		if (offset + size > m_written)
+		{
+			throw std::logic_error("Cannot overwrite bytes that are not yet written");
+		}
+		writeAt(offset, data, size);
+	}
+
+	/**
+	 * Number of bytes written so far, buffered ones included
+	 */
+	uint64_t position() const
+	{ return m_written + m_used; }
+
+	/**
+	 * Flushes and closes the file
+	 */
+	void close()
+	{
+		flush();
+#ifdef _WIN32
+		int status = _close(m_fd);
+#else
+		int status = ::close(m_fd);
+#endif
+		m_fd = -1;
+		if (status != 0)
+		{
+			throw std::runtime_error(std::string("Failed to close file: ") + std::strerror(errno));
+		}
+	}
+
+private:
+	void writeAt(uint64_t offset, const uint8_t *data, size_t size)
+	{
+		while (size > 0)
+		{
+#ifdef _WIN32
+			if (_lseeki64(m_fd, (__int64) offset, SEEK_SET) == -1)
+			{
+				throw std::runtime_error(std::string("Failed to seek: ") + std::strerror(errno));
+			}
+			int count = _write(m_fd, data, (unsigned int) std::min<size_t>(size, 1u << 30));
+#else
+			ssize_t count = ::pwrite(m_fd, data, size, (off_t) offset);
+#endif
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				throw std::runtime_error(std::string("Failed to write: ") + std::strerror(errno));
+			}
+			data += count;
+			offset += count;
+			size -= count;
+		}
+	}
+
+	int m_fd;
+	LazPerfArray<uint8_t> m_storage;
+	uint8_t *m_buffer;
+	size_t m_bufferSize;
+	size_t m_used;
+	uint64_t m_written;
+};
+
+#endif //LAZPERF_C_BUFFERED_FILE_H
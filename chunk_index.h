@@ -0,0 +1,156 @@
+#ifndef LAZPERF_C_CHUNK_INDEX_H
+#define LAZPERF_C_CHUNK_INDEX_H
+
+#include "lazperf_c.h"
+#include "allocator.h"
+#include "bounds.h"
+#include "las_header.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/*
+ * Serialized chunk index, all values little endian:
+ *
+ *   char[4]  magic "LZCI"
+ *   uint32   version (1)
+ *   uint32   number of chunks
+ *   then for each chunk:
+ *     int32[3]  min X, Y, Z (as stored in the point records)
+ *     int32[3]  max X, Y, Z
+ *     double    min gps time
+ *     double    max gps time
+ */
+#define CHUNK_INDEX_MAGIC "LZCI"
+#define CHUNK_INDEX_VERSION 1
+#define CHUNK_INDEX_HEADER_SIZE 12
+#define CHUNK_INDEX_ENTRY_SIZE 40
+
+
+/**
+ * Computes the bounds and the gps time range of each chunk, as the points are compressed
+ */
+class ChunkIndexBuilder
+{
+public:
+	/**
+	 * @param pointSize size of one point
+	 * @param gpsTimeOffset position of the gps time in a point, -1 if the points have none
+	 */
+	ChunkIndexBuilder(size_t pointSize, long gpsTimeOffset)
+			: m_pointSize(pointSize), m_gpsTimeOffset(gpsTimeOffset)
+	{
+		resetChunk();
+	}
+
+	void add(const uint8_t *points, size_t count)
+	{
+		expandBounds(m_chunkBounds, points, count, m_pointSize);
+		if (m_gpsTimeOffset >= 0)
+		{
+			const uint8_t *gpsTime = points + m_gpsTimeOffset;
+			for (size_t i = 0; i < count; ++i, gpsTime += m_pointSize)
+			{
+				double value = readLe<double>(gpsTime);
+				m_chunkMinGpsTime = std::min(m_chunkMinGpsTime, value);
+				m_chunkMaxGpsTime = std::max(m_chunkMaxGpsTime, value);
+			}
+		}
+	}
+
+	void closeChunk()
+	{
+		m_bounds.push_back(m_chunkBounds);
+		m_minGpsTimes.push_back(m_chunkMinGpsTime);
+		m_maxGpsTimes.push_back(m_chunkMaxGpsTime);
+		resetChunk();
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		std::vector<uint8_t> data(CHUNK_INDEX_HEADER_SIZE + CHUNK_INDEX_ENTRY_SIZE * m_bounds.size());
+		std::memcpy(data.data(), CHUNK_INDEX_MAGIC, 4);
+		writeLe<uint32_t>(data.data() + 4, CHUNK_INDEX_VERSION);
+		writeLe<uint32_t>(data.data() + 8, (uint32_t) m_bounds.size());
+
+		uint8_t *entry = data.data() + CHUNK_INDEX_HEADER_SIZE;
+		for (size_t i = 0; i < m_bounds.size(); ++i, entry += CHUNK_INDEX_ENTRY_SIZE)
+		{
+			for (size_t j = 0; j < 3; ++j)
+			{
+				writeLe<int32_t>(entry + 4 * j, m_bounds[i].mins[j]);
+				writeLe<int32_t>(entry + 12 + 4 * j, m_bounds[i].maxs[j]);
+			}
+			writeLe<double>(entry + 24, m_minGpsTimes[i]);
+			writeLe<double>(entry + 32, m_maxGpsTimes[i]);
+		}
+		return data;
+	}
+
+private:
+	void resetChunk()
+	{
+		m_chunkBounds = emptyBounds();
+		m_chunkMinGpsTime = m_gpsTimeOffset >= 0 ? std::numeric_limits<double>::max() : 0.0;
+		m_chunkMaxGpsTime = m_gpsTimeOffset >= 0 ? std::numeric_limits<double>::lowest() : 0.0;
+	}
+
+	size_t m_pointSize;
+	long m_gpsTimeOffset;
+	LazPerf_Bounds m_chunkBounds;
+	double m_chunkMinGpsTime;
+	double m_chunkMaxGpsTime;
+	std::vector<LazPerf_Bounds> m_bounds;
+	std::vector<double> m_minGpsTimes;
+	std::vector<double> m_maxGpsTimes;
+};
+
+
+/**
+ * Reads a chunk index serialized by ChunkIndexBuilder, the arrays of the returned index are allocated with 'lazperfAllocArray'
+ */
+inline LazPerf_ChunkIndex parseChunkIndex(const uint8_t *data, size_t size)
+{
+	if (size < CHUNK_INDEX_HEADER_SIZE || std::memcmp(data, CHUNK_INDEX_MAGIC, 4) != 0)
+	{
+		throw std::runtime_error("Not a chunk index");
+	}
+	if (readLe<uint32_t>(data + 4) != CHUNK_INDEX_VERSION)
+	{
+		throw std::runtime_error("Unsupported chunk index version");
+	}
+	size_t numChunks = readLe<uint32_t>(data + 8);
+	if ((size - CHUNK_INDEX_HEADER_SIZE) / CHUNK_INDEX_ENTRY_SIZE < numChunks)
+	{
+		throw std::runtime_error("Chunk index is truncated");
+	}
+
+	LazPerfArray<LazPerf_Bounds> bounds(lazperfAllocArray<LazPerf_Bounds>(numChunks));
+	LazPerfArray<double> minGpsTimes(lazperfAllocArray<double>(numChunks));
+	LazPerfArray<double> maxGpsTimes(lazperfAllocArray<double>(numChunks));
+	const uint8_t *entry = data + CHUNK_INDEX_HEADER_SIZE;
+	for (size_t i = 0; i < numChunks; ++i, entry += CHUNK_INDEX_ENTRY_SIZE)
+	{
+		for (size_t j = 0; j < 3; ++j)
+		{
+			bounds[i].mins[j] = readLe<int32_t>(entry + 4 * j);
+			bounds[i].maxs[j] = readLe<int32_t>(entry + 12 + 4 * j);
+		}
+		minGpsTimes[i] = readLe<double>(entry + 24);
+		maxGpsTimes[i] = readLe<double>(entry + 32);
+	}
+
+	LazPerf_ChunkIndex index{};
+	index.num_chunks = numChunks;
+	index.bounds = bounds.release();
+	index.min_gps_times = minGpsTimes.release();
+	index.max_gps_times = maxGpsTimes.release();
+	return index;
+}
+
+#endif //LAZPERF_C_CHUNK_INDEX_H
@@ -0,0 +1,202 @@
+#ifndef LAZPERF_C_CHUNK_TABLE_H
+#define LAZPERF_C_CHUNK_TABLE_H
+
+#include "stream_utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <laz-perf/common/common.hpp>
+#include <laz-perf/compressor.hpp>
+#include <laz-perf/decoder.hpp>
+#include <laz-perf/decompressor.hpp>
+#include <laz-perf/encoder.hpp>
+
+/**
+ * Chunk size stored in the laszip vlr when each chunk has its own number of points,
+ * which is then stored in the chunk table
+ */
+#define VARIABLE_CHUNK_SIZE UINT32_MAX
+
+/**
+ * Throws if 'chunkSize' cannot be used as a fixed number of points per chunk
+ */
+inline void checkChunkSize(uint32_t chunkSize)
+{
+	if (chunkSize == 0)
+	{
+		throw std::runtime_error("The chunk size cannot be 0");
+	}
+	if (chunkSize == VARIABLE_CHUNK_SIZE)
+	{
+		throw std::runtime_error("The chunk size 0xFFFFFFFF is reserved for variable size chunks");
+	}
+}
+
+/**
+ * Position and size of one chunk of compressed points.
+ *
+ * 'offset' is relative to the start of the compressed points,
+ * that is, just past the 8 bytes offset to the chunk table.
+ */
+struct ChunkInfo
+{
+	uint64_t offset;
+	uint64_t byteCount;
+	uint64_t pointCount;
+	uint64_t firstPoint;
+};
+
+
+/**
+ * Writes the chunk table (header and arithmetic coded chunk sizes) to the stream
+ *
+ * @param stream where the chunk table is written
+ * @param chunkSizes compressed size in bytes of each chunk
+ * @param chunkPointCounts number of points of each chunk, only for variable size chunks, empty otherwise
+ */
+template<typename TStream>
+void writeChunkTable(
+		TStream &stream,
+		const std::vector<uint32_t> &chunkSizes,
+		const std::vector<uint32_t> &chunkPointCounts = std::vector<uint32_t>())
+{
+	bool variable = !chunkPointCounts.empty();
+	if (variable && chunkPointCounts.size() != chunkSizes.size())
+	{
+		throw std::logic_error("There must be a point count for each chunk");
+	}
+
+	uint32_t header[2] = {htole32(0), htole32((uint32_t) chunkSizes.size())};
+	stream.putBytes(reinterpret_cast<const unsigned char *>(header), sizeof(header));
+
+	laszip::encoders::arithmetic<TStream> encoder(stream);
+	laszip::compressors::integer compressor(32, 2);
+	compressor.init();
+
+	// Like LASzip, the point count (if any) and the size of a chunk are predicted from the previous chunk's
+	uint32_t countPredictor = 0;
+	uint32_t predictor = 0;
+	for (size_t i = 0; i < chunkSizes.size(); ++i)
+	{
+		if (variable)
+		{
+			uint32_t pointCount = htole32(chunkPointCounts[i]);
+			compressor.compress(encoder, countPredictor, pointCount, 0);
+			countPredictor = pointCount;
+		}
+		uint32_t chunkSize = htole32(chunkSizes[i]);
+		compressor.compress(encoder, predictor, chunkSize, 1);
+		predictor = chunkSize;
+	}
+	encoder.done();
+}
+
+
+/**
+ * Reads the chunk table written by writeChunkTable.
+ *
+ * @param data the compressed points (without the 8 bytes offset to the chunk table)
+ * @param dataLength size of data
+ * @param chunkTablePos position of the chunk table in data
+ * @param chunkSize number of points per chunk, as stored in the laszip vlr (VARIABLE_CHUNK_SIZE
+ * if the point count of each chunk is stored in the table)
+ * @param numPoints total number of points
+ */
+inline std::vector<ChunkInfo> readChunkTable(
+		const uint8_t *data,
+		size_t dataLength,
+		uint64_t chunkTablePos,
+		uint32_t chunkSize,
+		uint64_t numPoints)
+{
+	if (chunkTablePos > dataLength || dataLength - chunkTablePos < 2 * sizeof(uint32_t))
+	{
+		throw std::runtime_error("Chunk table position is past the end of the buffer");
+	}
+
+	uint32_t version;
+	uint32_t numChunks;
+	std::memcpy(&version, data + chunkTablePos, sizeof(uint32_t));
+	std::memcpy(&numChunks, data + chunkTablePos + sizeof(uint32_t), sizeof(uint32_t));
+	version = le32toh(version);
+	numChunks = le32toh(numChunks);
+	if (version != 0)
+	{
+		throw std::runtime_error("Unsupported chunk table version");
+	}
+	bool variable = chunkSize == VARIABLE_CHUNK_SIZE;
+	// Without points, VlrCompressor still closes the (empty) chunk it started, so the table has one entry
+	bool emptyChunk = numPoints == 0 && numChunks == 1;
+	if (!variable && !emptyChunk && (chunkSize == 0 || numChunks != (numPoints + chunkSize - 1) / chunkSize))
+	{
+		throw std::runtime_error("Chunk table does not match the number of points");
+	}
+
+	size_t entriesPos = chunkTablePos + 2 * sizeof(uint32_t);
+	ReadOnlyStream stream(data + entriesPos, dataLength - entriesPos);
+	laszip::decoders::arithmetic<ReadOnlyStream> decoder(stream);
+	laszip::decompressors::integer decompressor(32, 2);
+	std::vector<ChunkInfo> chunks;
+	chunks.reserve(numChunks);
+
+	if (numChunks != 0)
+	{
+		decoder.readInitBytes();
+		decompressor.init();
+	}
+
+	uint32_t countPredictor = 0;
+	uint32_t predictor = 0;
+	uint64_t offset = 0;
+	uint64_t firstPoint = 0;
+	for (uint32_t i = 0; i < numChunks; ++i)
+	{
+		if (variable)
+		{
+			countPredictor = (uint32_t) decompressor.decompress(decoder, countPredictor, 0);
+		}
+		predictor = (uint32_t) decompressor.decompress(decoder, predictor, 1);
+
+		ChunkInfo chunk{};
+		chunk.offset = offset;
+		chunk.byteCount = le32toh(predictor);
+		chunk.firstPoint = firstPoint;
+		if (variable)
+		{
+			chunk.pointCount = le32toh(countPredictor);
+			if (chunk.pointCount > numPoints - firstPoint)
+			{
+				throw std::runtime_error("Chunk table describes more points than there are");
+			}
+		}
+		else
+		{
+			chunk.pointCount = std::min<uint64_t>(chunkSize, numPoints - firstPoint);
+		}
+		chunks.push_back(chunk);
+
+		offset += chunk.byteCount;
+		firstPoint += chunk.pointCount;
+	}
+
+	if (variable && firstPoint != numPoints)
+	{
+		throw std::runtime_error("Chunk table does not match the number of points");
+	}
+	if (offset > chunkTablePos)
+	{
+		throw std::runtime_error("Chunk table describes more bytes than there are compressed points");
+	}
+	if (numPoints == 0)
+	{
+		// There is nothing to decompress in the empty chunk
+		chunks.clear();
+	}
+	return chunks;
+}
+
+#endif //LAZPERF_C_CHUNK_TABLE_H
@@ -0,0 +1,154 @@
+#ifndef LAZPERF_C_COLUMNS_H
+#define LAZPERF_C_COLUMNS_H
+
+#include "lazperf_c.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/**
+ * Where the fields unpacked to columns are in a (pointwise, LAS format 0 to 5) point record.
+ * The offsets of the optional items are -1 when the record does not have them.
+ */
+struct ColumnLayout
+{
+	size_t pointSize;
+	long gpsTimeOffset;
+	long rgbOffset;
+};
+
+
+/**
+ * out[i] = in[i] * scale + offset
+ */
+inline void scaleToDouble(const int32_t *in, size_t count, double scale, double offset, double *out)
+{
+	size_t i = 0;
+#if defined(__AVX__)
+	const __m256d scales = _mm256_set1_pd(scale);
+	const __m256d offsets = _mm256_set1_pd(offset);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d values = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+		_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(values, scales), offsets));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	const __m128d scales = _mm_set1_pd(scale);
+	const __m128d offsets = _mm_set1_pd(offset);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d values = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i)));
+		_mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(values, scales), offsets));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		out[i] = in[i] * scale + offset;
+	}
+}
+
+template<typename T>
+inline void gatherField(const uint8_t *points, size_t count, size_t pointSize, size_t fieldOffset, T *out)
+{
+	points += fieldOffset;
+	for (size_t i = 0; i < count; ++i, points += pointSize)
+	{
+		std::memcpy(out + i, points, sizeof(T));
+	}
+}
+
+/**
+ * Unpacks 'count' points into the columns, starting at row 'firstRow' of each column.
+ *
+ * X, Y and Z are first gathered as int32 in a small buffer, and then scaled in one vectorized pass,
+ * so the points must be processed in blocks of at most 'BlockSize'.
+ */
+class ColumnUnpacker
+{
+public:
+	static const size_t BlockSize = 1024;
+
+	ColumnUnpacker(const ColumnLayout &layout, const double *scales, const double *offsets)
+			: m_layout(layout)
+	{
+		std::copy(scales, scales + 3, m_scales);
+		std::copy(offsets, offsets + 3, m_offsets);
+	}
+
+	void unpack(const uint8_t *points, size_t count, const LazPerf_Columns &columns, size_t firstRow)
+	{
+		const size_t pointSize = m_layout.pointSize;
+		double *xyz[3] = {columns.x, columns.y, columns.z};
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (xyz[i])
+			{
+				gatherField(points, count, pointSize, 4 * i, m_raw);
+				scaleToDouble(m_raw, count, m_scales[i], m_offsets[i], xyz[i] + firstRow);
+			}
+		}
+
+		if (columns.intensity)
+		{
+			gatherField(points, count, pointSize, 12, columns.intensity + firstRow);
+		}
+		if (columns.return_number || columns.number_of_returns)
+		{
+			const uint8_t *flags = points + 14;
+			for (size_t i = 0; i < count; ++i, flags += pointSize)
+			{
+				if (columns.return_number)
+				{
+					columns.return_number[firstRow + i] = *flags & 0x07;
+				}
+				if (columns.number_of_returns)
+				{
+					columns.number_of_returns[firstRow + i] = (*flags >> 3) & 0x07;
+				}
+			}
+		}
+		if (columns.classification)
+		{
+			const uint8_t *classification = points + 15;
+			uint8_t *out = columns.classification + firstRow;
+			for (size_t i = 0; i < count; ++i, classification += pointSize)
+			{
+				// The 3 high bits are the synthetic, key-point and withheld flags
+				out[i] = *classification & 0x1F;
+			}
+		}
+		if (columns.point_source_id)
+		{
+			gatherField(points, count, pointSize, 18, columns.point_source_id + firstRow);
+		}
+		if (columns.gps_time)
+		{
+			gatherField(points, count, pointSize, (size_t) m_layout.gpsTimeOffset, columns.gps_time + firstRow);
+		}
+		if (columns.red)
+		{
+			gatherField(points, count, pointSize, (size_t) m_layout.rgbOffset, columns.red + firstRow);
+		}
+		if (columns.green)
+		{
+			gatherField(points, count, pointSize, (size_t) m_layout.rgbOffset + 2, columns.green + firstRow);
+		}
+		if (columns.blue)
+		{
+			gatherField(points, count, pointSize, (size_t) m_layout.rgbOffset + 4, columns.blue + firstRow);
+		}
+	}
+
+private:
+	ColumnLayout m_layout;
+	double m_scales[3];
+	double m_offsets[3];
+	int32_t m_raw[BlockSize];
+};
+
+#endif //LAZPERF_C_COLUMNS_H
@@ -0,0 +1,217 @@
+#ifndef LAZPERF_C_LAS_HEADER_H
+#define LAZPERF_C_LAS_HEADER_H
+
+#include "lazperf_c.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+/* Offsets of the fields of the LAS public header block */
+#define LAS_HEADER_VERSION_MAJOR 24
+#define LAS_HEADER_HEADER_SIZE 94
+#define LAS_HEADER_OFFSET_TO_POINT_DATA 96
+#define LAS_HEADER_NUMBER_OF_VLRS 100
+#define LAS_HEADER_POINT_FORMAT 104
+#define LAS_HEADER_LEGACY_POINT_COUNT 107
+#define LAS_HEADER_SCALES 131
+#define LAS_HEADER_START_OF_FIRST_EVLR 235
+#define LAS_HEADER_POINT_COUNT 247
+
+#define LAS_HEADER_SIZE_1_2 227
+#define LAS_HEADER_SIZE_1_3 235
+#define LAS_HEADER_SIZE_1_4 375
+#define VLR_HEADER_SIZE 54
+
+#define LASZIP_VLR_USER_ID "laszip encoded"
+#define LASZIP_VLR_RECORD_ID 22204
+
+/* Offsets in the record data of the laszip VLR */
+#define LASZIP_VLR_CHUNK_SIZE 12
+#define LASZIP_VLR_NUM_ITEMS 32
+#define LASZIP_VLR_ITEMS 34
+#define LASZIP_VLR_ITEM_SIZE 6
+
+
+template<typename T>
+inline T readLe(const uint8_t *data)
+{
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+/**
+ * Parses the LAS public header block
+ */
+inline LazPerf_LasHeader parseLasHeader(const uint8_t *data, size_t size)
+{
+	if (size < LAS_HEADER_SIZE_1_2 || std::memcmp(data, "LASF", 4) != 0)
+	{
+		throw std::runtime_error("Not a LAS file");
+	}
+
+	LazPerf_LasHeader header{};
+	header.file_source_id = readLe<uint16_t>(data + 4);
+	header.global_encoding = readLe<uint16_t>(data + 6);
+	header.version_major = data[LAS_HEADER_VERSION_MAJOR];
+	header.version_minor = data[LAS_HEADER_VERSION_MAJOR + 1];
+	std::memcpy(header.system_identifier, data + 26, sizeof(header.system_identifier));
+	std::memcpy(header.generating_software, data + 58, sizeof(header.generating_software));
+	header.creation_day = readLe<uint16_t>(data + 90);
+	header.creation_year = readLe<uint16_t>(data + 92);
+	header.header_size = readLe<uint16_t>(data + LAS_HEADER_HEADER_SIZE);
+	header.offset_to_point_data = readLe<uint32_t>(data + LAS_HEADER_OFFSET_TO_POINT_DATA);
+	header.number_of_vlrs = readLe<uint32_t>(data + LAS_HEADER_NUMBER_OF_VLRS);
+	// The 2 high bits are set by LASzip to mark compressed points
+	header.point_format = data[LAS_HEADER_POINT_FORMAT] & 0x3F;
+	header.point_size = readLe<uint16_t>(data + LAS_HEADER_POINT_FORMAT + 1);
+	header.point_count = readLe<uint32_t>(data + LAS_HEADER_LEGACY_POINT_COUNT);
+	for (size_t i = 0; i < 5; ++i)
+	{
+		header.points_by_return[i] = readLe<uint32_t>(data + LAS_HEADER_LEGACY_POINT_COUNT + 4 + 4 * i);
+	}
+	for (size_t i = 0; i < 3; ++i)
+	{
+		header.scales[i] = readLe<double>(data + LAS_HEADER_SCALES + 8 * i);
+		header.offsets[i] = readLe<double>(data + LAS_HEADER_SCALES + 24 + 8 * i);
+		header.maxs[i] = readLe<double>(data + LAS_HEADER_SCALES + 48 + 16 * i);
+		header.mins[i] = readLe<double>(data + LAS_HEADER_SCALES + 56 + 16 * i);
+	}
+
+	if (header.header_size > size || header.offset_to_point_data < header.header_size)
+	{
+		throw std::runtime_error("Invalid LAS header");
+	}
+
+	if (header.version_minor >= 4 && header.header_size >= LAS_HEADER_SIZE_1_4)
+	{
+		header.start_of_first_evlr = readLe<uint64_t>(data + LAS_HEADER_START_OF_FIRST_EVLR);
+		uint64_t point_count = readLe<uint64_t>(data + LAS_HEADER_POINT_COUNT);
+		if (point_count != 0)
+		{
+			header.point_count = point_count;
+			for (size_t i = 0; i < 15; ++i)
+			{
+				header.points_by_return[i] = readLe<uint64_t>(data + LAS_HEADER_POINT_COUNT + 8 + 8 * i);
+			}
+		}
+	}
+	return header;
+}
+
+template<typename T>
+inline void writeLe(uint8_t *data, T value)
+{
+	std::memcpy(data, &value, sizeof(T));
+}
+
+/**
+ * Serializes the public header block, 'out' must be at least header.header_size bytes
+ */
+inline void serializeLasHeader(const LazPerf_LasHeader &header, uint8_t *out)
+{
+	std::memset(out, 0, header.header_size);
+	std::memcpy(out, "LASF", 4);
+	writeLe<uint16_t>(out + 4, header.file_source_id);
+	writeLe<uint16_t>(out + 6, header.global_encoding);
+	out[LAS_HEADER_VERSION_MAJOR] = header.version_major;
+	out[LAS_HEADER_VERSION_MAJOR + 1] = header.version_minor;
+	std::memcpy(out + 26, header.system_identifier, sizeof(header.system_identifier));
+	std::memcpy(out + 58, header.generating_software, sizeof(header.generating_software));
+	writeLe<uint16_t>(out + 90, header.creation_day);
+	writeLe<uint16_t>(out + 92, header.creation_year);
+	writeLe<uint16_t>(out + LAS_HEADER_HEADER_SIZE, header.header_size);
+	writeLe<uint32_t>(out + LAS_HEADER_OFFSET_TO_POINT_DATA, header.offset_to_point_data);
+	writeLe<uint32_t>(out + LAS_HEADER_NUMBER_OF_VLRS, header.number_of_vlrs);
+	// Mark the points as compressed, like LASzip does
+	out[LAS_HEADER_POINT_FORMAT] = header.point_format | 0x80;
+	writeLe<uint16_t>(out + LAS_HEADER_POINT_FORMAT + 1, header.point_size);
+
+	// Legacy counts are 0 when they do not fit or for the point formats that LAS < 1.4 does not know
+	bool legacyCounts = header.point_format < 6 && header.point_count <= UINT32_MAX;
+	writeLe<uint32_t>(out + LAS_HEADER_LEGACY_POINT_COUNT, legacyCounts ? (uint32_t) header.point_count : 0);
+	for (size_t i = 0; i < 5; ++i)
+	{
+		uint64_t count = header.points_by_return[i];
+		writeLe<uint32_t>(out + LAS_HEADER_LEGACY_POINT_COUNT + 4 + 4 * i,
+						  legacyCounts && count <= UINT32_MAX ? (uint32_t) count : 0);
+	}
+	for (size_t i = 0; i < 3; ++i)
+	{
+		writeLe<double>(out + LAS_HEADER_SCALES + 8 * i, header.scales[i]);
+		writeLe<double>(out + LAS_HEADER_SCALES + 24 + 8 * i, header.offsets[i]);
+		writeLe<double>(out + LAS_HEADER_SCALES + 48 + 16 * i, header.maxs[i]);
+		writeLe<double>(out + LAS_HEADER_SCALES + 56 + 16 * i, header.mins[i]);
+	}
+
+	if (header.header_size >= LAS_HEADER_SIZE_1_4)
+	{
+		writeLe<uint64_t>(out + LAS_HEADER_START_OF_FIRST_EVLR, header.start_of_first_evlr);
+		writeLe<uint64_t>(out + LAS_HEADER_POINT_COUNT, header.point_count);
+		for (size_t i = 0; i < 15; ++i)
+		{
+			writeLe<uint64_t>(out + LAS_HEADER_POINT_COUNT + 8 + 8 * i, header.points_by_return[i]);
+		}
+	}
+}
+
+/**
+ * Returns the size of the public header block for the given minor version
+ */
+inline uint16_t lasHeaderSize(uint8_t versionMinor)
+{
+	if (versionMinor >= 4)
+	{
+		return LAS_HEADER_SIZE_1_4;
+	}
+	if (versionMinor == 3)
+	{
+		return LAS_HEADER_SIZE_1_3;
+	}
+	return LAS_HEADER_SIZE_1_2;
+}
+
+/**
+ * Looks for the laszip VLR in the VLRs that follow the header
+ *
+ * @param dataOffset set to the offset of the record data of the VLR in the file
+ * @param dataSize set to the size of the record data of the VLR
+ * @return whether the VLR was found
+ */
+inline bool findLaszipVlr(
+		const uint8_t *data,
+		size_t size,
+		const LazPerf_LasHeader &header,
+		size_t &dataOffset,
+		size_t &dataSize)
+{
+	size_t pos = header.header_size;
+	for (uint32_t i = 0; i < header.number_of_vlrs; ++i)
+	{
+		if (pos + VLR_HEADER_SIZE > size)
+		{
+			throw std::runtime_error("VLR header is past the end of the file");
+		}
+		const uint8_t *vlrHeader = data + pos;
+		uint16_t recordId = readLe<uint16_t>(vlrHeader + 18);
+		uint16_t recordLength = readLe<uint16_t>(vlrHeader + 20);
+		pos += VLR_HEADER_SIZE;
+
+		if (pos + recordLength > size)
+		{
+			throw std::runtime_error("VLR data is past the end of the file");
+		}
+		if (recordId == LASZIP_VLR_RECORD_ID
+			&& std::strncmp(reinterpret_cast<const char *>(vlrHeader + 2), LASZIP_VLR_USER_ID, 16) == 0)
+		{
+			dataOffset = pos;
+			dataSize = recordLength;
+			return true;
+		}
+		pos += recordLength;
+	}
+	return false;
+}
+
+#endif //LAZPERF_C_LAS_HEADER_H
@@ -1,10 +1,24 @@
 #include "lazperf_c.h"
+#include "allocator.h"
 #include "stream_utils.h"
+#include "chunk_table.h"
+#include "parallel_utils.h"
+#include "mapped_file.h"
+#include "las_header.h"
+#include "buffered_file.h"
+#include "columns.h"
+#include "bounds.h"
+#include "chunk_index.h"
+#include "stats.h"
+#include "batch.h"
+#include "point_codecs.h"
 
 #include <iostream>
 #include <utility>
 #include <istream>
 #include <cstring>
+#include <algorithm>
+#include <condition_variable>
 
 #include <laz-perf/common/common.hpp>
 #include <laz-perf/compressor.hpp>
@@ -24,18 +38,230 @@ static_assert(sizeof(char) == sizeof(uint8_t), "The 'char' type needs to have th
 
 typedef laszip::factory::record_schema Schema;
 
+template<typename TEncoder>
+static laszip::formats::dynamic_compressor::ptr buildCompressor(TEncoder &encoder, const Schema &schema)
+{
+	laszip::formats::dynamic_compressor::ptr compressor = laszip::factory::build_compressor(encoder, schema);
+	if (!compressor)
+	{
+		throw std::runtime_error("Unsupported record schema");
+	}
+	return compressor;
+}
+
+template<typename TDecoder>
+static laszip::formats::dynamic_decompressor::ptr buildDecompressor(TDecoder &decoder, const Schema &schema)
+{
+	laszip::formats::dynamic_decompressor::ptr decompressor = laszip::factory::build_decompressor(decoder, schema);
+	if (!decompressor)
+	{
+		throw std::runtime_error("Unsupported record schema");
+	}
+	return decompressor;
+}
+
+/**
+ * Builds the codec of the schema, specialized at compile time for the layouts of PointLayout.
+ * They are the codecs laz-perf's factory builds for these layouts, so the bytes are the same either way.
+ */
+template<typename TEncoder>
+static typename PointCompressor<TEncoder>::ptr buildPointCompressor(
+		TEncoder &encoder,
+		const Schema &schema,
+		PointCompressorStorage<TEncoder> &storage)
+{
+	using namespace laszip::formats;
+	typedef typename PointCompressor<TEncoder>::ptr Ptr;
+
+	CodecDeleter inPlace(true);
+	switch (pointLayout(schema))
+	{
+		case PointLayout::Point:
+			return Ptr(new(&storage) StaticPointCompressor<TEncoder, las::point10>(encoder), inPlace);
+		case PointLayout::PointGpsTime:
+			return Ptr(new(&storage) StaticPointCompressor<TEncoder, las::point10, las::gpstime>(encoder), inPlace);
+		case PointLayout::PointRgb:
+			return Ptr(new(&storage) StaticPointCompressor<TEncoder, las::point10, las::rgb>(encoder), inPlace);
+		case PointLayout::PointGpsTimeRgb:
+			return Ptr(new(&storage) StaticPointCompressor<TEncoder, las::point10, las::gpstime, las::rgb>(encoder),
+					   inPlace);
+		case PointLayout::Dynamic:
+			break;
+	}
+	// laz-perf's factory allocates the dynamic codecs anyway
+	return Ptr(new DynamicPointCompressor<TEncoder>(buildCompressor(encoder, schema)));
+}
+
+template<typename TDecoder>
+static typename PointDecompressor<TDecoder>::ptr buildPointDecompressor(
+		TDecoder &decoder,
+		const Schema &schema,
+		PointDecompressorStorage<TDecoder> &storage)
+{
+	using namespace laszip::formats;
+	typedef typename PointDecompressor<TDecoder>::ptr Ptr;
+
+	CodecDeleter inPlace(true);
+	switch (pointLayout(schema))
+	{
+		case PointLayout::Point:
+			return Ptr(new(&storage) StaticPointDecompressor<TDecoder, las::point10>(decoder), inPlace);
+		case PointLayout::PointGpsTime:
+			return Ptr(new(&storage) StaticPointDecompressor<TDecoder, las::point10, las::gpstime>(decoder), inPlace);
+		case PointLayout::PointRgb:
+			return Ptr(new(&storage) StaticPointDecompressor<TDecoder, las::point10, las::rgb>(decoder), inPlace);
+		case PointLayout::PointGpsTimeRgb:
+			return Ptr(new(&storage) StaticPointDecompressor<TDecoder, las::point10, las::gpstime, las::rgb>(decoder),
+					   inPlace);
+		case PointLayout::Dynamic:
+			break;
+	}
+	return Ptr(new DynamicPointDecompressor<TDecoder>(buildDecompressor(decoder, schema)));
+}
+
+/**
+ * Returns the position of the gps time in the points of the schema, -1 if they have none
+ */
+static long gpsTimeOffset(const Schema &schema)
+{
+	long offset = 0;
+	for (const laszip::factory::record_item &item : schema.records)
+	{
+		if (item == laszip::factory::record_item::gpstime())
+		{
+			return offset;
+		}
+		offset += item.size;
+	}
+	return -1;
+}
+
+/**
+ * Returns the schema described by the record data of a laszip vlr
+ */
+static Schema schemaFromVlr(const char *vlrData, size_t pointSize)
+{
+	return laszip::io::laz_vlr::to_schema(laszip::io::laz_vlr(vlrData), (int) pointSize);
+}
+
+
+/**
+ * Estimates the compressed bytes of each record item, by compressing the points once more for each
+ * schema made of the first 1, 2... items: an item costs what its schema adds to the previous one.
+ * As the models of the items are independent, this is close to what each item costs in the real stream.
+ */
+class ItemBytesMeter
+{
+public:
+	explicit ItemBytesMeter(const Schema &schema) : m_pointSize((size_t) schema.size_in_bytes())
+	{
+		size_t numPrefixes = std::min(schema.records.size(), (size_t) LAZPERF_STATS_MAX_ITEMS);
+		for (size_t i = 1; i < numPrefixes; ++i)
+		{
+			Schema prefix;
+			for (size_t j = 0; j < i; ++j)
+			{
+				prefix.push(schema.records[j]);
+			}
+			m_prefixes.push_back(prefix);
+		}
+		// The last one counts all the remaining items
+		m_prefixes.push_back(schema);
+	}
+
+	size_t numItems() const
+	{ return m_prefixes.size(); }
+
+	void add(const char *points, size_t count)
+	{
+		if (m_shadows.empty())
+		{
+			for (const Schema &prefix : m_prefixes)
+			{
+				m_shadows.emplace_back(new Shadow(prefix));
+			}
+		}
+		for (std::unique_ptr<Shadow> &shadow : m_shadows)
+		{
+			const char *point = points;
+			for (size_t i = 0; i < count; ++i, point += m_pointSize)
+			{
+				shadow->compressor->compress(point);
+			}
+		}
+	}
+
+	/**
+	 * Whether points were added since the last 'closeChunk' or 'reset'
+	 */
+	bool empty() const
+	{ return m_shadows.empty(); }
+
+	/**
+	 * Adds the bytes of each item of the points added so far to 'itemBytes', and starts over
+	 */
+	void closeChunk(uint64_t *itemBytes)
+	{
+		uint64_t previous = 0;
+		for (size_t i = 0; i < m_shadows.size(); ++i)
+		{
+			m_shadows[i]->encoder.done();
+			itemBytes[i] += m_shadows[i]->stream.count - previous;
+			previous = m_shadows[i]->stream.count;
+		}
+		m_shadows.clear();
+	}
+
+	/**
+	 * Forgets the points of the current chunk
+	 */
+	void reset()
+	{
+		m_shadows.clear();
+	}
+
+private:
+	struct CountingStream
+	{
+		uint64_t count = 0;
+
+		void putBytes(const unsigned char *, size_t len)
+		{ count += len; }
+
+		void putByte(unsigned char)
+		{ count++; }
+	};
+
+	typedef laszip::encoders::arithmetic<CountingStream> Encoder;
+
+	struct Shadow
+	{
+		explicit Shadow(const Schema &schema) : encoder(stream), compressor(buildCompressor(encoder, schema))
+		{}
+
+		CountingStream stream;
+		Encoder encoder;
+		laszip::formats::dynamic_compressor::ptr compressor;
+	};
+
+	size_t m_pointSize;
+	std::vector<Schema> m_prefixes;
+	std::vector<std::unique_ptr<Shadow>> m_shadows;
+};
+
 
 class VlrCompressor
 {
 public:
 	explicit VlrCompressor(Schema s)
-			: m_stream(m_data_vec), m_encoder(nullptr), m_chunkPointsWritten(0),
+			: m_stream(m_data_vec), m_chunkPointsWritten(0),
 			  m_chunkInfoPos(0), m_chunkOffset(0), m_schema(std::move(std::move(s))),
-			  m_vlr(laszip::io::laz_vlr::from_schema(m_schema)), m_chunksize(m_vlr.chunk_size)
+			  m_vlr(laszip::io::laz_vlr::from_schema(m_schema)), m_chunksize(m_vlr.chunk_size),
+			  m_write(nullptr), m_patch(nullptr), m_sinkUserData(nullptr), m_offsetToPointData(0)
 	{
 	}
 
-	const std::vector<uint8_t> *data() const;
+	const ByteBuffer *data() const;
 
 	const uint8_t *internalBuffer() const
 	{
@@ -44,6 +270,8 @@ public:
 
 	size_t compress(const char *inbuf);
 
+	size_t compressMany(const char *inbuf, size_t count);
+
 	uint64_t done();
 
 	uint64_t writeChunkTable();
@@ -52,7 +280,7 @@ public:
 	{ return m_vlr.size(); }
 
 	void extractVlrData(char *out_data)
-	{ return m_vlr.extract(out_data); }
+	{ m_vlr.extract(out_data); }
 
 	size_t getPointSize() const
 	{ return (size_t) m_schema.size_in_bytes(); }
@@ -76,19 +304,104 @@ public:
 		return copiedSize;
 	}
 
+	/**
+	 * Makes the compressor hand each chunk to 'write' as soon as the chunk is closed,
+	 * instead of keeping the data in its internal buffer.
+	 * Once the chunk table is written, 'patch' is called to write the offset to the chunk table.
+	 */
+	void setSink(LazPerf_WriteCallback write, LazPerf_PatchCallback patch, void *userData, uint64_t offsetToPointData)
+	{
+		m_write = write;
+		m_patch = patch;
+		m_sinkUserData = userData;
+		m_offsetToPointData = offsetToPointData;
+	}
+
+	/**
+	 * Makes the compressor compute the bounds and gps time range of each chunk
+	 */
+	void enableChunkIndex()
+	{
+		if (m_encoder || !m_chunkTable.empty())
+		{
+			throw std::runtime_error("The chunk index must be enabled before compressing points");
+		}
+		m_index.reset(new ChunkIndexBuilder(getPointSize(), gpsTimeOffset(m_schema)));
+	}
+
+	const ChunkIndexBuilder *chunkIndex() const
+	{ return m_index.get(); }
+
+	/**
+	 * Makes the compressor record statistics about each chunk
+	 */
+	void enableStats(bool measureItemBytes)
+	{
+		if (m_encoder || !m_chunkTable.empty())
+		{
+			throw std::runtime_error("The statistics must be enabled before compressing points");
+		}
+		if (measureItemBytes)
+		{
+			m_itemBytes.reset(new ItemBytesMeter(m_schema));
+		}
+		m_stats.reset(new ChunkStatsRecorder(m_itemBytes ? m_itemBytes->numItems() : 0));
+	}
+
+	LazPerf_Stats stats() const
+	{ return m_stats ? m_stats->view() : LazPerf_Stats{}; }
+
+	/**
+	 * Makes each chunk hold the points compressed until 'closeChunk' is called,
+	 * instead of a fixed number of points
+	 */
+	void enableVariableChunks()
+	{
+		applyChunkSize(VARIABLE_CHUNK_SIZE);
+	}
+
+	void setChunkSize(uint32_t chunkSize)
+	{
+		checkChunkSize(chunkSize);
+		applyChunkSize(chunkSize);
+	}
+
+	void closeChunk();
+
 
 private:
 	typedef laszip::encoders::arithmetic<TypedLazPerfBuf<uint8_t>> Encoder;
 
-	typedef laszip::formats::dynamic_compressor Compressor;
+	typedef PointCompressor<Encoder> Compressor;
+
+	void applyChunkSize(uint32_t chunkSize)
+	{
+		if (m_encoder || !m_chunkTable.empty())
+		{
+			throw std::runtime_error("The chunk size must be set before compressing points");
+		}
+		m_chunksize = chunkSize;
+		m_vlr.chunk_size = chunkSize;
+	}
+
+	void startChunkIfNeeded();
+
+	/**
+	 * Reserves the room for the offset to the chunk table, before the first chunk
+	 */
+	void skipChunkTableOffset();
 
 	void resetCompressor();
 
 	void newChunk();
 
-	std::vector<uint8_t> m_data_vec;
+	void flushToSink();
+
+	ByteBuffer m_data_vec;
 	TypedLazPerfBuf<uint8_t> m_stream;
-	std::unique_ptr<Encoder> m_encoder;
+	// Declared before the compressor, which refers to them
+	InPlace<Encoder> m_encoder;
+	PointCompressorStorage<Encoder> m_compressorStorage;
 	Compressor::ptr m_compressor;
 	uint32_t m_chunkPointsWritten;
 	uint64_t m_chunkInfoPos;
@@ -98,96 +411,228 @@ private:
 	uint32_t m_chunksize;
 
 	std::vector<uint32_t> m_chunkTable;
+	std::vector<uint32_t> m_chunkPointCounts;
+
+	LazPerf_WriteCallback m_write;
+	LazPerf_PatchCallback m_patch;
+	void *m_sinkUserData;
+	uint64_t m_offsetToPointData;
+
+	std::unique_ptr<ChunkIndexBuilder> m_index;
+	std::unique_ptr<ChunkStatsRecorder> m_stats;
+	std::unique_ptr<ItemBytesMeter> m_itemBytes;
 };
 
 
 size_t VlrCompressor::compress(const char *inbuf)
 {
-	// First time through.
+	if (m_stats)
+	{
+		return compressMany(inbuf, 1);
+	}
+	startChunkIfNeeded();
+	if (m_index)
+	{
+		m_index->add(reinterpret_cast<const uint8_t *>(inbuf), 1);
+	}
+	m_compressor->compressMany(inbuf, 1, getPointSize());
+	m_chunkPointsWritten++;
+	return m_data_vec.size();
+}
+
+size_t VlrCompressor::compressMany(const char *inbuf, size_t count)
+{
+	size_t pointSize = getPointSize();
+	while (count > 0)
+	{
+		startChunkIfNeeded();
+		// Compress the run of points up to the end of the current chunk without further checks
+		size_t run = std::min<size_t>(count, m_chunksize - m_chunkPointsWritten);
+		LazPerf_ChunkStats *stats = m_stats ? m_stats->current() : nullptr;
+		if (m_itemBytes)
+		{
+			// Not timed, the seconds of the stats are those of the compression alone
+			m_itemBytes->add(inbuf, run);
+		}
+		ScopedTimer timer(stats ? &stats->seconds : nullptr);
+		if (m_index)
+		{
+			m_index->add(reinterpret_cast<const uint8_t *>(inbuf), run);
+		}
+		m_compressor->compressMany(inbuf, run, pointSize);
+		inbuf += run * pointSize;
+		m_chunkPointsWritten += (uint32_t) run;
+		if (stats)
+		{
+			stats->point_count += run;
+		}
+		count -= run;
+	}
+	return m_data_vec.size();
+}
+
+void VlrCompressor::startChunkIfNeeded()
+{
 	if (!m_encoder || !m_compressor)
 	{
-		// Seek over the chunk info offset value
-		unsigned char skip[sizeof(uint64_t)] = {0};
-		m_stream.putBytes(skip, sizeof(skip));
-		m_chunkOffset = m_chunkInfoPos + sizeof(uint64_t);
+		// First time through.
+		if (m_chunkTable.empty())
+		{
+			skipChunkTableOffset();
+		}
 		resetCompressor();
 	}
 	else if (m_chunkPointsWritten == m_chunksize)
 	{
-		resetCompressor();
+		m_encoder->done();
 		newChunk();
+		resetCompressor();
 	}
-	m_compressor->compress(inbuf);
-	m_chunkPointsWritten++;
-	return m_data_vec.size();
 }
 
 
+void VlrCompressor::closeChunk()
+{
+	if (m_chunksize != VARIABLE_CHUNK_SIZE)
+	{
+		throw std::runtime_error("Chunks can only be closed explicitly when they have a variable size");
+	}
+	if (!m_encoder || m_chunkPointsWritten == 0)
+	{
+		return;
+	}
+	m_encoder->done();
+	m_compressor.reset();
+	m_encoder.reset();
+	newChunk();
+}
+
 uint64_t VlrCompressor::done()
 {
 	// Close and clear the point encoder.
 	if (m_encoder)
 	{
 		m_encoder->done();
+		m_compressor.reset();
 		m_encoder.reset();
+		newChunk();
+	}
+	else if (m_chunkTable.empty())
+	{
+		// No point was written, the empty chunk still needs the room for the offset to the chunk table
+		skipChunkTableOffset();
+		newChunk();
 	}
-
-	newChunk();
 	return m_stream.m_buf.size();
 }
 
+void VlrCompressor::skipChunkTableOffset()
+{
+	unsigned char skip[sizeof(uint64_t)] = {0};
+	m_stream.putBytes(skip, sizeof(skip));
+	m_chunkOffset = m_chunkInfoPos + sizeof(uint64_t);
+}
+
 void VlrCompressor::resetCompressor()
 {
-	if (m_encoder)
-		m_encoder->done();
-	m_encoder.reset(new Encoder(m_stream));
-	m_compressor = laszip::factory::build_compressor(*m_encoder, m_schema);
+	LazPerf_ChunkStats *stats = m_stats ? &m_stats->startNextChunk() : nullptr;
+	ScopedTimer timer(stats ? &stats->model_reset_seconds : nullptr);
+	ScopedTimer totalTimer(stats ? &stats->seconds : nullptr);
+	m_compressor.reset();
+	m_compressor = buildPointCompressor(m_encoder.emplace(m_stream), m_schema, m_compressorStorage);
 }
 
 void VlrCompressor::newChunk()
 {
 	size_t offset = m_stream.totalWritten();
 	m_chunkTable.push_back((uint32_t) (offset - m_chunkOffset));
+	m_chunkPointCounts.push_back(m_chunkPointsWritten);
 	m_chunkOffset = offset;
+	// The only chunk without points is the one of an empty file, its readers see no chunk to index
+	if (m_index && m_chunkPointsWritten != 0)
+	{
+		m_index->closeChunk();
+	}
 	m_chunkPointsWritten = 0;
+	if (m_stats && m_stats->current())
+	{
+		m_stats->current()->compressed_bytes = m_chunkTable.back();
+		if (m_itemBytes)
+		{
+			m_itemBytes->closeChunk(m_stats->current()->item_bytes);
+		}
+	}
+	flushToSink();
+}
+
+void VlrCompressor::flushToSink()
+{
+	if (m_write && !m_data_vec.empty())
+	{
+		LazPerf_ChunkStats *stats = m_stats ? m_stats->current() : nullptr;
+		ScopedTimer timer(stats ? &stats->io_seconds : nullptr);
+		m_write(m_sinkUserData, m_data_vec.data(), m_data_vec.size());
+		resetStreamPosition();
+	}
 }
 
-const std::vector<uint8_t> *VlrCompressor::data() const
+const ByteBuffer *VlrCompressor::data() const
 {
 	return &m_stream.m_buf;
 }
 
 uint64_t VlrCompressor::writeChunkTable()
 {
-	uint64_t chunkTablePos = m_stream.m_buf.size();
+	uint64_t chunkTablePos = m_stream.totalWritten();
+	if (m_chunksize == VARIABLE_CHUNK_SIZE)
+	{
+		::writeChunkTable(m_stream, m_chunkTable, m_chunkPointCounts);
+	}
+	else
+	{
+		::writeChunkTable(m_stream, m_chunkTable);
+	}
+	flushToSink();
+	if (m_patch)
+	{
+		LazPerf_ChunkStats *stats = m_stats ? m_stats->current() : nullptr;
+		ScopedTimer timer(stats ? &stats->io_seconds : nullptr);
+		uint64_t offsetToChunkTable = htole64(chunkTablePos + m_offsetToPointData);
+		m_patch(m_sinkUserData, 0, reinterpret_cast<const uint8_t *>(&offsetToChunkTable), sizeof(uint64_t));
+	}
+	return m_stream.m_buf.size();
+}
 
-	// Write the chunk table header in two steps
-	// 1. Push bytes into the stream
-	// 2. memcpy the data into the pushed bytes
-	unsigned char skip[2 * sizeof(uint32_t)] = {0};
-	m_stream.putBytes(skip, sizeof(skip));
-	uint32_t version = htole32(0);
-	uint32_t chunkTableSize = htole32((uint32_t) m_chunkTable.size());
+/**
+ * Picks a chunk size giving each thread a few chunks to balance the work,
+ * without making the chunks so small that they compress poorly or so large that seeking gets slow.
+ */
+static uint32_t autoChunkSize(uint64_t expectedPointCount, size_t numThreads)
+{
+	const uint64_t ChunksPerThread = 4;
+	const uint64_t MinChunkSize = 10000;
+	const uint64_t MaxChunkSize = 500000;
 
-	std::memcpy(&m_stream.m_buf[chunkTablePos], &version, sizeof(uint32_t));
-	std::memcpy(&m_stream.m_buf[chunkTablePos + sizeof(uint32_t)], &chunkTableSize, sizeof(uint32_t));
+	uint64_t numChunks = ChunksPerThread * resolveThreadCount(numThreads);
+	uint64_t chunkSize = (expectedPointCount + numChunks - 1) / numChunks;
+	return (uint32_t) std::max(MinChunkSize, std::min(MaxChunkSize, chunkSize));
+}
 
-	// Encode and write the chunk table.
-	// OutputStream outputStream(m_stream);
-	TypedLazPerfBuf<uint8_t> outputStream(m_stream);
-	Encoder encoder(outputStream);
-	laszip::compressors::integer compressor(32, 2);
-	compressor.init();
+/**
+ * Compresses 'numPoints' points as one chunk, with a fresh encoder, and writes them to the stream.
+ * This produces the same bytes VlrCompressor produces for a chunk, so that chunks compressed
+ * separately can be concatenated.
+ */
+template<typename TStream>
+static void compressChunk(TStream &stream, const Schema &schema, const char *points, uint64_t numPoints)
+{
+	typedef laszip::encoders::arithmetic<TStream> Encoder;
 
-	uint32_t predictor = 0;
-	for (uint32_t chunkSize : m_chunkTable)
-	{
-		chunkSize = htole32(chunkSize);
-		compressor.compress(encoder, predictor, chunkSize, 1);
-		predictor = chunkSize;
-	}
+	Encoder encoder(stream);
+	PointCompressorStorage<Encoder> storage;
+	typename PointCompressor<Encoder>::ptr compressor = buildPointCompressor(encoder, schema, storage);
+	compressor->compressMany(points, (size_t) numPoints, (size_t) schema.size_in_bytes());
 	encoder.done();
-	return m_stream.m_buf.size();
 }
 
 
@@ -195,6 +640,33 @@ uint64_t VlrCompressor::writeChunkTable()
  * Decompression
  **********************************************************************************************************************/
 
+static ColumnLayout columnLayout(const Schema &schema)
+{
+	if (schema.records.empty() || !(schema.records[0] == laszip::factory::record_item::point()))
+	{
+		throw std::runtime_error("Columnar decompression needs a schema that starts with the point item");
+	}
+
+	ColumnLayout layout{};
+	layout.pointSize = (size_t) schema.size_in_bytes();
+	layout.gpsTimeOffset = -1;
+	layout.rgbOffset = -1;
+	long offset = 0;
+	for (const laszip::factory::record_item &item : schema.records)
+	{
+		if (item == laszip::factory::record_item::gpstime())
+		{
+			layout.gpsTimeOffset = offset;
+		}
+		else if (item == laszip::factory::record_item::rgb())
+		{
+			layout.rgbOffset = offset;
+		}
+		offset += item.size;
+	}
+	return layout;
+}
+
 class VlrDecompressor
 {
 public:
@@ -203,281 +675,2295 @@ public:
 			size_t dataLength,
 			size_t pointSize,
 			const char *vlr_data)
-			: m_stream(compressedData, dataLength), m_chunksize(0), m_chunkPointsRead(0)
+			: m_stream(compressedData, dataLength), m_chunksize(0), m_chunkPointsRead(0),
+			  m_chunkPointCount(0), m_pointIndex(0), m_chunkStartPosition(0)
 	{
-		laszip::io::laz_vlr zipvlr(vlr_data);
-		m_chunksize = zipvlr.chunk_size;
-		m_schema = laszip::io::laz_vlr::to_schema(zipvlr, pointSize);
+		readVlr(vlr_data, pointSize);
+	}
+
+	/**
+	 * Creates a decompressor that pulls the compressed data from 'read'
+	 * using blocks of 'bufferSize' bytes
+	 */
+	VlrDecompressor(
+			PrefetchingSource::ReadFn read,
+			void *userData,
+			size_t bufferSize,
+			size_t pointSize,
+			const char *vlr_data)
+			: m_source(new PrefetchingSource(read, userData, bufferSize)), m_stream(m_source.get()),
+			  m_chunksize(0), m_chunkPointsRead(0), m_chunkPointCount(0), m_pointIndex(0),
+			  m_chunkStartPosition(0)
+	{
+		readVlr(vlr_data, pointSize);
 	}
 
 	size_t getPointSize() const
 	{ return (size_t) m_schema.size_in_bytes(); }
 
+	/**
+	 * Makes the decompressor start over on another buffer of points compressed with the same laszip vlr,
+	 * keeping the schema and the buffers it already allocated.
+	 * The chunk table and the chunk bounds of the previous buffer are forgotten.
+	 */
+	void reset(const uint8_t *compressedData, size_t dataLength)
+	{
+		if (m_source)
+		{
+			throw std::runtime_error("A decompressor reading from a source cannot be reset to a buffer");
+		}
+		m_stream.reset(compressedData, dataLength);
+		m_decompressor.reset();
+		m_chunkPointsRead = 0;
+		m_chunkPointCount = 0;
+		m_pointIndex = 0;
+		m_chunks.clear();
+		m_chunkBounds.clear();
+	}
+
 	void decompress(char *out)
 	{
-		if (m_chunkPointsRead == m_chunksize || !m_decoder || !m_decompressor)
+		if (m_stats)
 		{
-			resetDecompressor();
-			m_chunkPointsRead = 0;
+			decompressMany(out, 1);
+			return;
 		}
-		m_decompressor->decompress(out);
+		startChunkIfNeeded();
+		m_decompressor->decompressMany(out, 1, getPointSize());
 		m_chunkPointsRead++;
+		m_pointIndex++;
 	}
 
-
-private:
-	void resetDecompressor()
+	void decompressMany(char *out, size_t count)
 	{
-		m_decoder.reset(new Decoder(m_stream));
-		m_decompressor =
-				laszip::factory::build_decompressor(*m_decoder, m_schema);
+		size_t pointSize = getPointSize();
+		while (count > 0)
+		{
+			startChunkIfNeeded();
+			// Decompress the run of points up to the end of the current chunk without further checks
+			size_t run = (size_t) std::min<uint64_t>(count, m_chunkPointCount - m_chunkPointsRead);
+			if (m_stats)
+			{
+				decompressRunWithStats(out, run);
+				out += run * pointSize;
+			}
+			else
+			{
+				m_decompressor->decompressMany(out, run, pointSize);
+				out += run * pointSize;
+			}
+			m_chunkPointsRead += (uint32_t) run;
+			m_pointIndex += run;
+			count -= run;
+		}
 	}
 
+	/**
+	 * Reads the chunk table, which is needed to seek
+	 *
+	 * @param chunkTablePos position of the chunk table in the compressed data
+	 * @param numPoints total number of points in the compressed data
+	 */
+	void readChunkTable(uint64_t chunkTablePos, uint64_t numPoints)
+	{
+		if (m_source)
+		{
+			throw std::runtime_error("Cannot read the chunk table of a decompressor that reads from a source");
+		}
+		m_chunks = ::readChunkTable(m_stream.m_data, m_stream.m_dataLength, chunkTablePos, m_chunksize, numPoints);
+	}
 
-	typedef laszip::formats::dynamic_decompressor Decompressor;
-	typedef laszip::factory::record_schema Schema;
-	typedef laszip::decoders::arithmetic<ReadOnlyStream> Decoder;
-
-	ReadOnlyStream m_stream;
+	/**
+	 * Moves the decompressor so that the next decompressed point is the point at 'pointIndex'.
+	 *
+	 * Jumps to the start of the chunk that contains the point and only decompresses
+	 * the points that precede it in that chunk, or just skips points when the target
+	 * is further in the chunk currently being decompressed.
+	 */
+	void seek(uint64_t pointIndex)
+	{
+		if (m_chunks.empty())
+		{
+			throw std::runtime_error("The chunk table must be read before seeking");
+		}
+		const ChunkInfo &lastChunk = m_chunks.back();
+		if (pointIndex >= lastChunk.firstPoint + lastChunk.pointCount)
+		{
+			throw std::out_of_range("Point index is past the number of points");
+		}
 
-	std::unique_ptr<Decoder> m_decoder;
-	Decompressor::ptr m_decompressor;
-	Schema m_schema;
-	uint32_t m_chunksize;
-	uint32_t m_chunkPointsRead;
-};
+		auto chunk = std::upper_bound(m_chunks.begin(), m_chunks.end(), pointIndex,
+									  [](uint64_t index, const ChunkInfo &c)
+									  { return index < c.firstPoint; }) - 1;
 
+		bool inCurrentChunk = m_decompressor
+							  && m_pointIndex > chunk->firstPoint
+							  && m_pointIndex <= pointIndex;
+		if (!inCurrentChunk)
+		{
+			moveToChunk(*chunk);
+		}
 
-/***********************************************************************************************************************
- * Purely C API
- **********************************************************************************************************************/
+		m_scratch.resize(getPointSize());
+		while (m_pointIndex < pointIndex)
+		{
+			decompress(m_scratch.data());
+		}
+	}
 
-void lazperf_delete_sized_buffer(struct LazPerf_SizedBuffer buffer)
-{
-	delete buffer.data;
-}
+	/**
+	 * Decompresses 'count' points into the columns, one block of points at a time
+	 * so that the points are unpacked while they are still in cache.
+	 */
+	void decompressColumns(size_t count, const double *scales, const double *offsets, const LazPerf_Columns &columns)
+	{
+		ColumnLayout layout = columnLayout(m_schema);
+		if (columns.gps_time && layout.gpsTimeOffset < 0)
+		{
+			throw std::runtime_error("The points have no gps time");
+		}
+		if ((columns.red || columns.green || columns.blue) && layout.rgbOffset < 0)
+		{
+			throw std::runtime_error("The points have no rgb");
+		}
 
+		ColumnUnpacker unpacker(layout, scales, offsets);
+		m_scratch.resize(ColumnUnpacker::BlockSize * layout.pointSize);
+		for (size_t row = 0; row < count;)
+		{
+			size_t blockCount = std::min(count - row, (size_t) ColumnUnpacker::BlockSize);
+			decompressMany(m_scratch.data(), blockCount);
+			unpacker.unpack(reinterpret_cast<const uint8_t *>(m_scratch.data()), blockCount, columns, row);
+			row += blockCount;
+		}
+	}
 
-static LazPerf_SizedBuffer _lazperf_decompress_points(const uint8_t *compressed_points_buffer,
-													  size_t buffer_size,
-													  const char *lazsip_vlr_data,
-													  size_t num_points,
-													  size_t point_size)
-{
-	VlrDecompressor decompressor(compressed_points_buffer, buffer_size, point_size, lazsip_vlr_data);
-	std::unique_ptr<char[]> decompressed_points(new char[point_size * num_points]);
-	LazPerf_SizedBuffer buffer{};
 
-	char *current_point = decompressed_points.get();
-	for (size_t i = 0; i < num_points; ++i)
+	/**
+	 * Makes the decompressor record statistics about each chunk
+	 */
+	void enableStats(bool measureItemBytes)
 	{
-		decompressor.decompress(current_point);
-		current_point += point_size;
+		if (m_decompressor)
+		{
+			throw std::runtime_error("The statistics must be enabled before decompressing points");
+		}
+		if (measureItemBytes)
+		{
+			m_itemBytes.reset(new ItemBytesMeter(m_schema));
+		}
+		m_stats.reset(new ChunkStatsRecorder(m_itemBytes ? m_itemBytes->numItems() : 0));
+		if (m_source)
+		{
+			m_source->measureWaits();
+		}
+	}
+
+	LazPerf_Stats stats()
+	{
+		if (m_itemBytes && !m_itemBytes->empty())
+		{
+			// Without the chunk table, the end of a partial last chunk cannot be told apart from the middle
+			// of a chunk: its items are measured over the points decompressed so far
+			m_itemBytes->closeChunk(m_stats->current()->item_bytes);
+		}
+		return m_stats ? m_stats->view() : LazPerf_Stats{};
+	}
+
+	size_t numChunks() const
+	{ return m_chunks.size(); }
+
+	const std::vector<LazPerf_Bounds> &computeChunkBounds()
+	{
+		if (m_chunks.empty())
+		{
+			throw std::runtime_error("The chunk table must be read before computing the chunk bounds");
+		}
+
+		size_t pointSize = getPointSize();
+		std::vector<LazPerf_Bounds> chunkBounds;
+		chunkBounds.reserve(m_chunks.size());
+		for (const ChunkInfo &chunk : m_chunks)
+		{
+			moveToChunk(chunk);
+			LazPerf_Bounds bounds = emptyBounds();
+			for (uint64_t remaining = chunk.pointCount; remaining > 0;)
+			{
+				size_t count = (size_t) std::min(remaining, (uint64_t) QueryBlockSize);
+				m_scratch.resize(count * pointSize);
+				decompressMany(m_scratch.data(), count);
+				expandBounds(bounds, reinterpret_cast<const uint8_t *>(m_scratch.data()), count, pointSize);
+				remaining -= count;
+			}
+			chunkBounds.push_back(bounds);
+		}
+		m_chunkBounds = std::move(chunkBounds);
+		return m_chunkBounds;
+	}
+
+	void setChunkBounds(const LazPerf_Bounds *bounds, size_t count)
+	{
+		if (count != m_chunks.size())
+		{
+			throw std::runtime_error("The number of chunk bounds does not match the number of chunks");
+		}
+		m_chunkBounds.assign(bounds, bounds + count);
+	}
+
+	/**
+	 * Appends the points inside 'box' to 'out', only decompressing the chunks that intersect it
+	 */
+	void queryBox(const LazPerf_Bounds &box, ResultBuffer &out)
+	{
+		if (m_chunkBounds.empty())
+		{
+			computeChunkBounds();
+		}
+
+		size_t pointSize = getPointSize();
+		for (size_t i = 0; i < m_chunks.size(); ++i)
+		{
+			const ChunkInfo &chunk = m_chunks[i];
+			if (chunk.pointCount == 0 || !boundsIntersect(box, m_chunkBounds[i]))
+			{
+				continue;
+			}
+
+			moveToChunk(chunk);
+			if (boundsContain(box, m_chunkBounds[i]))
+			{
+				decompressMany(out.grow(chunk.pointCount * pointSize), chunk.pointCount);
+				continue;
+			}
+
+			for (uint64_t remaining = chunk.pointCount; remaining > 0;)
+			{
+				size_t count = (size_t) std::min(remaining, (uint64_t) QueryBlockSize);
+				m_scratch.resize(count * pointSize);
+				decompressMany(m_scratch.data(), count);
+				for (size_t j = 0; j < count; ++j)
+				{
+					const char *point = m_scratch.data() + j * pointSize;
+					if (pointInBounds(box, reinterpret_cast<const uint8_t *>(point)))
+					{
+						out.append(point, pointSize);
+					}
+				}
+				remaining -= count;
+			}
+		}
+	}
+
+private:
+	static const size_t QueryBlockSize = 1024;
+
+	/**
+	 * Positions the decompressor at the first point of the chunk
+	 */
+	void moveToChunk(const ChunkInfo &chunk)
+	{
+		m_stream.seek(chunk.offset);
+		m_pointIndex = chunk.firstPoint;
+		resetDecompressor();
+		m_chunkPointsRead = 0;
+		m_chunkPointCount = chunk.pointCount;
+	}
+
+	void readVlr(const char *vlr_data, size_t pointSize)
+	{
+		laszip::io::laz_vlr zipvlr(vlr_data);
+		m_chunksize = zipvlr.chunk_size;
+		m_schema = schemaFromVlr(vlr_data, pointSize);
+	}
+
+	void startChunkIfNeeded()
+	{
+		if (m_chunkPointsRead == m_chunkPointCount || !m_decompressor)
+		{
+			resetDecompressor();
+			m_chunkPointsRead = 0;
+			m_chunkPointCount = pointCountOfChunkAt(m_pointIndex);
+		}
+	}
+
+	/**
+	 * Returns the number of points of the chunk starting at 'firstPoint'
+	 */
+	uint64_t pointCountOfChunkAt(uint64_t firstPoint) const
+	{
+		if (m_chunks.empty())
+		{
+			if (m_chunksize == VARIABLE_CHUNK_SIZE)
+			{
+				throw std::runtime_error("The chunk table must be read to decompress variable size chunks");
+			}
+			// Only the chunk table tells whether the last chunk has fewer points
+			return m_chunksize;
+		}
+		auto chunk = std::upper_bound(m_chunks.begin(), m_chunks.end(), firstPoint,
+									  [](uint64_t index, const ChunkInfo &c)
+									  { return index < c.firstPoint; });
+		if (chunk == m_chunks.begin() || (chunk - 1)->firstPoint != firstPoint)
+		{
+			throw std::runtime_error("No chunk starts at this point");
+		}
+		return (chunk - 1)->pointCount;
+	}
+
+	/**
+	 * Starts the decoder and the models of a new chunk over.
+	 *
+	 * Each chunk needs a fresh decoder, as the decoder only reloads its value (not its interval length)
+	 * when it is initialized by the first point of the chunk. The decoder and the codec of the common layouts
+	 * (see PointLayout) are rebuilt in place, only the tables of laz-perf's models are allocated again.
+	 */
+	void resetDecompressor()
+	{
+		LazPerf_ChunkStats *stats = m_stats ? &m_stats->startChunk(m_pointIndex) : nullptr;
+		ScopedTimer timer(stats ? &stats->model_reset_seconds : nullptr);
+		ScopedTimer totalTimer(stats ? &stats->seconds : nullptr);
+		m_decompressor.reset();
+		m_decompressor = buildPointDecompressor(m_decoder.emplace(m_stream), m_schema, m_decompressorStorage);
+		if (stats)
+		{
+			m_chunkStartPosition = m_stream.position();
+			if (m_itemBytes)
+			{
+				m_itemBytes->reset();
+			}
+		}
+	}
+
+	/**
+	 * Decompresses 'count' points of the current chunk, recording what it costs
+	 */
+	void decompressRunWithStats(char *out, size_t count)
+	{
+		LazPerf_ChunkStats &stats = *m_stats->current();
+		double waitSeconds = m_source ? m_source->waitSeconds() : 0;
+		{
+			ScopedTimer timer(&stats.seconds);
+			m_decompressor->decompressMany(out, count, getPointSize());
+		}
+		if (m_itemBytes)
+		{
+			// Not timed, like when compressing
+			m_itemBytes->add(out, count);
+		}
+		stats.point_count += count;
+		stats.compressed_bytes = m_stream.position() - m_chunkStartPosition;
+		if (m_source)
+		{
+			stats.io_seconds += m_source->waitSeconds() - waitSeconds;
+		}
+		if (m_itemBytes && m_chunkPointsRead + count == m_chunkPointCount)
+		{
+			m_itemBytes->closeChunk(stats.item_bytes);
+		}
+	}
+
+
+	typedef laszip::factory::record_schema Schema;
+	typedef laszip::decoders::arithmetic<ReadOnlyStream> Decoder;
+	typedef PointDecompressor<Decoder> Decompressor;
+
+	std::unique_ptr<PrefetchingSource> m_source;
+	ReadOnlyStream m_stream;
+
+	// Declared before the decompressor, which refers to them
+	InPlace<Decoder> m_decoder;
+	PointDecompressorStorage<Decoder> m_decompressorStorage;
+	Decompressor::ptr m_decompressor;
+	Schema m_schema;
+	uint32_t m_chunksize;
+	uint32_t m_chunkPointsRead;
+	uint64_t m_chunkPointCount;
+	uint64_t m_pointIndex;
+	std::vector<ChunkInfo> m_chunks;
+	std::vector<LazPerf_Bounds> m_chunkBounds;
+	std::vector<char, LazPerfAllocator<char>> m_scratch;
+	std::unique_ptr<ChunkStatsRecorder> m_stats;
+	std::unique_ptr<ItemBytesMeter> m_itemBytes;
+	uint64_t m_chunkStartPosition;
+};
+
+
+/**
+ * Decompresses the 'numPoints' points of the chunk that starts at 'data'.
+ * Chunks are independent, so this can be called concurrently on different chunks.
+ */
+static void decompressChunk(
+		const uint8_t *data,
+		size_t dataLength,
+		const Schema &schema,
+		uint64_t numPoints,
+		char *out)
+{
+	typedef laszip::decoders::arithmetic<ReadOnlyStream> Decoder;
+
+	ReadOnlyStream stream(data, dataLength);
+	Decoder decoder(stream);
+	PointDecompressorStorage<Decoder> storage;
+	PointDecompressor<Decoder>::ptr decompressor = buildPointDecompressor(decoder, schema, storage);
+	decompressor->decompressMany(out, (size_t) numPoints, (size_t) schema.size_in_bytes());
+}
+
+
+/**
+ * Decompresses the chunks ahead of the consumer, on worker threads, into a fixed ring of buffers.
+ *
+ * Chunk i is decompressed into the buffer i % numBuffers, once the consumer released chunk i - numBuffers.
+ * The consumer gets the chunks in order, each one staying valid until it asks for the next one.
+ */
+class PrefetchingDecompressor
+{
+public:
+	PrefetchingDecompressor(
+			const uint8_t *compressedData,
+			size_t dataLength,
+			uint64_t chunkTableOffset,
+			const char *vlrData,
+			uint64_t numPoints,
+			size_t pointSize,
+			size_t numThreads,
+			size_t numBuffers)
+			: m_data(compressedData), m_chunkTableOffset(chunkTableOffset),
+			  m_schema(schemaFromVlr(vlrData, pointSize)), m_nextChunk(0), m_released(0), m_handedOut(false),
+			  m_stopping(false)
+	{
+		laszip::io::laz_vlr zipvlr(vlrData);
+		m_chunks = readChunkTable(compressedData, dataLength, chunkTableOffset, zipvlr.chunk_size, numPoints);
+
+		uint64_t maxChunkPoints = 0;
+		for (const ChunkInfo &chunk : m_chunks)
+		{
+			maxChunkPoints = std::max(maxChunkPoints, chunk.pointCount);
+		}
+		// The consumer does not decompress, so by default it leaves its core to the workers
+		numThreads = numThreads != 0 ? numThreads : std::max<size_t>(1, resolveThreadCount(0) - 1);
+		numBuffers = numBuffers != 0 ? numBuffers : 2 * numThreads;
+		numThreads = std::max<size_t>(1, std::min(numThreads, std::min(numBuffers, m_chunks.size())));
+
+		m_slots.resize(numBuffers);
+		for (Slot &slot : m_slots)
+		{
+			slot.points.resize((size_t) maxChunkPoints * pointSize);
+		}
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			m_workers.emplace_back(&PrefetchingDecompressor::work, this);
+		}
+	}
+
+	~PrefetchingDecompressor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_slotFreed.notify_all();
+		for (std::thread &worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	PrefetchingDecompressor(const PrefetchingDecompressor &) = delete;
+
+	PrefetchingDecompressor &operator=(const PrefetchingDecompressor &) = delete;
+
+	/**
+	 * Releases the chunk handed out by the previous call, and waits for the next one
+	 *
+	 * @param points set to the points of the chunk
+	 * @return the number of points of the chunk, 0 once all the chunks were handed out
+	 */
+	size_t nextChunk(const char **points)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_handedOut)
+		{
+			m_handedOut = false;
+			m_released++;
+			m_slotFreed.notify_all();
+		}
+		if (m_released == m_chunks.size())
+		{
+			*points = nullptr;
+			return 0;
+		}
+
+		Slot &slot = m_slots[m_released % m_slots.size()];
+		m_chunkReady.wait(lock, [&]()
+		{ return slot.chunk == m_released; });
+		if (slot.error)
+		{
+			std::rethrow_exception(slot.error);
+		}
+		m_handedOut = true;
+		*points = reinterpret_cast<const char *>(slot.points.data());
+		return (size_t) m_chunks[m_released].pointCount;
+	}
+
+private:
+	struct Slot
+	{
+		ByteBuffer points;
+		// Index of the chunk decompressed in the buffer, SIZE_MAX when there is none yet
+		size_t chunk = SIZE_MAX;
+		std::exception_ptr error;
+	};
+
+	void work()
+	{
+		for (;;)
+		{
+			size_t chunkIndex;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_slotFreed.wait(lock, [&]()
+				{
+					return m_stopping || m_nextChunk == m_chunks.size() || m_nextChunk < m_released + m_slots.size();
+				});
+				if (m_stopping || m_nextChunk == m_chunks.size())
+				{
+					return;
+				}
+				chunkIndex = m_nextChunk++;
+			}
+
+			Slot &slot = m_slots[chunkIndex % m_slots.size()];
+			std::exception_ptr error;
+			try
+			{
+				const ChunkInfo &chunk = m_chunks[chunkIndex];
+				decompressChunk(m_data + chunk.offset, m_chunkTableOffset - chunk.offset, m_schema, chunk.pointCount,
+								reinterpret_cast<char *>(slot.points.data()));
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				slot.chunk = chunkIndex;
+				slot.error = error;
+			}
+			m_chunkReady.notify_all();
+		}
+	}
+
+	const uint8_t *m_data;
+	uint64_t m_chunkTableOffset;
+	Schema m_schema;
+	std::vector<ChunkInfo> m_chunks;
+	std::vector<Slot> m_slots;
+
+	std::mutex m_mutex;
+	std::condition_variable m_slotFreed;
+	std::condition_variable m_chunkReady;
+	// Next chunk to hand to a worker
+	size_t m_nextChunk;
+	// Number of chunks the consumer is done with
+	size_t m_released;
+	bool m_handedOut;
+	bool m_stopping;
+	// Declared last so that the workers are started once everything else is initialized
+	std::vector<std::thread> m_workers;
+};
+
+
+/***********************************************************************************************************************
+ * LAZ file reader
+ **********************************************************************************************************************/
+
+class LazFileReader
+{
+public:
+	explicit LazFileReader(const char *path)
+			: m_file(path), m_header(parseLasHeader(m_file.data(), m_file.size())), m_laszipVlrData(nullptr),
+			  m_points(nullptr), m_pointsSize(0), m_chunkTableOffset(UINT64_MAX)
+	{
+		size_t vlrOffset = 0;
+		size_t vlrSize = 0;
+		if (!findLaszipVlr(m_file.data(), m_file.size(), m_header, vlrOffset, vlrSize))
+		{
+			throw std::runtime_error("The file has no laszip vlr, it is not a LAZ file");
+		}
+		const uint8_t *vlrData = m_file.data() + vlrOffset;
+		if (vlrSize < LASZIP_VLR_ITEMS
+			|| vlrSize < LASZIP_VLR_ITEMS + LASZIP_VLR_ITEM_SIZE * (size_t) readLe<uint16_t>(vlrData + LASZIP_VLR_NUM_ITEMS))
+		{
+			throw std::runtime_error("The laszip vlr is too small for its items");
+		}
+		m_laszipVlrData = reinterpret_cast<const char *>(m_file.data() + vlrOffset);
+
+		uint64_t pointsEnd = m_file.size();
+		if (m_header.start_of_first_evlr > m_header.offset_to_point_data && m_header.start_of_first_evlr < pointsEnd)
+		{
+			pointsEnd = m_header.start_of_first_evlr;
+		}
+		uint64_t pointsStart = m_header.offset_to_point_data + sizeof(uint64_t);
+		if (pointsStart > pointsEnd)
+		{
+			throw std::runtime_error("Point data is past the end of the file");
+		}
+		m_points = m_file.data() + pointsStart;
+		m_pointsSize = pointsEnd - pointsStart;
+		m_chunkTableOffset = lazperf_read_chunk_table_offset(
+				m_file.data() + m_header.offset_to_point_data, m_header.offset_to_point_data);
+		if (m_chunkTableOffset != UINT64_MAX && m_chunkTableOffset >= m_pointsSize)
+		{
+			m_chunkTableOffset = UINT64_MAX;
+		}
+	}
+
+	const LazPerf_LasHeader &header() const
+	{ return m_header; }
+
+	const char *laszipVlrData() const
+	{ return m_laszipVlrData; }
+
+	const uint8_t *points() const
+	{ return m_points; }
+
+	size_t pointsSize() const
+	{ return m_pointsSize; }
+
+	uint64_t chunkTableOffset() const
+	{ return m_chunkTableOffset; }
+
+	void advise(MappedFile::Access access) const
+	{
+		m_file.advise(access, m_points - m_file.data(), m_pointsSize);
+	}
+
+	VlrDecompressor *newDecompressor() const
+	{
+		std::unique_ptr<VlrDecompressor> decompressor(
+				new VlrDecompressor(m_points, m_pointsSize, m_header.point_size, m_laszipVlrData));
+		if (m_chunkTableOffset != UINT64_MAX)
+		{
+			decompressor->readChunkTable(m_chunkTableOffset, m_header.point_count);
+		}
+		return decompressor.release();
+	}
+
+private:
+	MappedFile m_file;
+	LazPerf_LasHeader m_header;
+	const char *m_laszipVlrData;
+	const uint8_t *m_points;
+	size_t m_pointsSize;
+	uint64_t m_chunkTableOffset;
+};
+
+
+/**
+ * Writes a LAZ file in one pass.
+ *
+ * The header and the VLRs are written when the first points are written (or when the writer finishes),
+ * the compressed chunks are streamed to the file as soon as they are closed, the offset to the chunk table
+ * and the final header are patched in place at the end.
+ */
+class LazFileWriter
+{
+public:
+	LazFileWriter(const char *path, const Schema &schema, const LazPerf_LasHeader &header)
+			: m_file(path), m_compressor(schema), m_header(header), m_pointSize(schema.size_in_bytes()),
+			  m_started(false), m_finished(false)
+	{
+		m_header.header_size = lasHeaderSize(m_header.version_minor);
+		m_header.point_size = (uint16_t) m_pointSize;
+		m_header.point_count = 0;
+		m_header.start_of_first_evlr = 0;
+		std::fill(std::begin(m_header.points_by_return), std::end(m_header.points_by_return), 0);
+		if (m_header.generating_software[0] == '\0')
+		{
+			std::strncpy(m_header.generating_software, "lazperf-c", sizeof(m_header.generating_software));
+		}
+		std::fill(std::begin(m_mins), std::end(m_mins), INT32_MAX);
+		std::fill(std::begin(m_maxs), std::end(m_maxs), INT32_MIN);
+
+		std::vector<uint8_t> laszipVlr(m_compressor.vlrDataSize());
+		m_compressor.extractVlrData(reinterpret_cast<char *>(laszipVlr.data()));
+		addVlr(LASZIP_VLR_USER_ID, LASZIP_VLR_RECORD_ID, "lazperf variant", laszipVlr.data(), laszipVlr.size());
+	}
+
+	void addVlr(const char *userId, uint16_t recordId, const char *description, const uint8_t *data, size_t size)
+	{
+		if (m_started)
+		{
+			throw std::runtime_error("VLRs must be added before the points are written");
+		}
+		if (size > UINT16_MAX)
+		{
+			throw std::runtime_error("VLR data is too large");
+		}
+
+		size_t pos = m_vlrs.size();
+		m_vlrs.resize(pos + VLR_HEADER_SIZE + size, 0);
+		uint8_t *vlrHeader = m_vlrs.data() + pos;
+		std::strncpy(reinterpret_cast<char *>(vlrHeader + 2), userId, 16);
+		writeLe<uint16_t>(vlrHeader + 18, recordId);
+		writeLe<uint16_t>(vlrHeader + 20, (uint16_t) size);
+		if (description)
+		{
+			std::strncpy(reinterpret_cast<char *>(vlrHeader + 22), description, 32);
+		}
+		if (size != 0)
+		{
+			std::memcpy(vlrHeader + VLR_HEADER_SIZE, data, size);
+		}
+		m_header.number_of_vlrs++;
+	}
+
+	void setChunkSize(uint32_t chunkSize)
+	{
+		if (m_started)
+		{
+			throw std::runtime_error("The chunk size must be set before the points are written");
+		}
+		m_compressor.setChunkSize(chunkSize);
+	}
+
+	void writePoints(const char *points, size_t count)
+	{
+		if (m_finished)
+		{
+			throw std::runtime_error("The file is already finished");
+		}
+		startIfNeeded();
+		updateStats(reinterpret_cast<const uint8_t *>(points), count);
+		m_compressor.compressMany(points, count);
+		m_header.point_count += count;
+	}
+
+	void finish()
+	{
+		if (m_finished)
+		{
+			return;
+		}
+		startIfNeeded();
+		// Even without points, so that the file has the offset to the chunk table and the (empty) chunk table
+		m_compressor.done();
+		m_compressor.writeChunkTable();
+		m_file.flush();
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (m_header.point_count != 0)
+			{
+				m_header.mins[i] = m_mins[i] * m_header.scales[i] + m_header.offsets[i];
+				m_header.maxs[i] = m_maxs[i] * m_header.scales[i] + m_header.offsets[i];
+			}
+			else
+			{
+				m_header.mins[i] = 0.0;
+				m_header.maxs[i] = 0.0;
+			}
+		}
+		std::vector<uint8_t> header(m_header.header_size);
+		serializeLasHeader(m_header, header.data());
+		m_file.pwrite(0, header.data(), header.size());
+		m_finished = true;
+		m_file.close();
+	}
+
+private:
+	/**
+	 * Writes the header (with placeholder counts and bounds) and the VLRs,
+	 * and plugs the compressor into the file
+	 */
+	void startIfNeeded()
+	{
+		if (m_started)
+		{
+			return;
+		}
+		// The laszip vlr is the first one, its chunk size may have changed since it was added
+		m_compressor.extractVlrData(reinterpret_cast<char *>(m_vlrs.data() + VLR_HEADER_SIZE));
+
+		m_header.offset_to_point_data = (uint32_t) (m_header.header_size + m_vlrs.size());
+		std::vector<uint8_t> header(m_header.header_size);
+		serializeLasHeader(m_header, header.data());
+		m_file.write(header.data(), header.size());
+		m_file.write(m_vlrs.data(), m_vlrs.size());
+		m_vlrs.clear();
+		m_vlrs.shrink_to_fit();
+
+		m_compressor.setSink(&LazFileWriter::sinkWrite, &LazFileWriter::sinkPatch, this,
+							 m_header.offset_to_point_data);
+		m_started = true;
+	}
+
+	void updateStats(const uint8_t *points, size_t count)
+	{
+		// The return number is 3 bits wide in the point formats 0 to 5 and 4 bits wide in the others
+		uint8_t returnMask = m_header.point_format < 6 ? 0x07 : 0x0F;
+		for (size_t i = 0; i < count; ++i, points += m_pointSize)
+		{
+			for (size_t j = 0; j < 3; ++j)
+			{
+				int32_t value = readLe<int32_t>(points + 4 * j);
+				m_mins[j] = std::min(m_mins[j], value);
+				m_maxs[j] = std::max(m_maxs[j], value);
+			}
+			uint8_t returnNumber = points[14] & returnMask;
+			if (returnNumber != 0)
+			{
+				m_header.points_by_return[returnNumber - 1]++;
+			}
+		}
+	}
+
+	static void sinkWrite(void *userData, const uint8_t *data, size_t size)
+	{
+		static_cast<LazFileWriter *>(userData)->m_file.write(data, size);
+	}
+
+	static void sinkPatch(void *userData, uint64_t offset, const uint8_t *data, size_t size)
+	{
+		auto writer = static_cast<LazFileWriter *>(userData);
+		writer->m_file.flush();
+		writer->m_file.pwrite(writer->m_header.offset_to_point_data + offset, data, size);
+	}
+
+	BufferedFile m_file;
+	VlrCompressor m_compressor;
+	LazPerf_LasHeader m_header;
+	size_t m_pointSize;
+	std::vector<uint8_t> m_vlrs;
+	int32_t m_mins[3];
+	int32_t m_maxs[3];
+	bool m_started;
+	bool m_finished;
+};
+
+
+/***********************************************************************************************************************
+ * Purely C API
+ **********************************************************************************************************************/
+
+/**
+ * Calls 'fn' and turns any exception it throws into an error result
+ */
+template<typename Fn>
+static LazPerf_VoidResult makeVoidResult(Fn fn)
+{
+	LazPerf_VoidResult result{};
+	try
+	{
+		fn();
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_sized_buffer(struct LazPerf_SizedBuffer buffer)
+{
+	lazperfFree(buffer.data);
+}
+
+void lazperf_set_allocator(
+		LazPerf_MallocFn malloc_fn,
+		LazPerf_ReallocFn realloc_fn,
+		LazPerf_FreeFn free_fn,
+		void *ctx)
+{
+	AllocatorHooks &hooks = allocatorHooks();
+	if (malloc_fn && realloc_fn && free_fn)
+	{
+		hooks = AllocatorHooks{malloc_fn, realloc_fn, free_fn, ctx};
+	}
+	else
+	{
+		hooks = AllocatorHooks{defaultMalloc, defaultRealloc, defaultFree, nullptr};
+	}
+}
+
+
+static LazPerf_SizedBuffer _lazperf_decompress_points(const uint8_t *compressed_points_buffer,
+													  size_t buffer_size,
+													  const char *lazsip_vlr_data,
+													  size_t num_points,
+													  size_t point_size)
+{
+	VlrDecompressor decompressor(compressed_points_buffer, buffer_size, point_size, lazsip_vlr_data);
+	LazPerfArray<char> decompressed_points(lazperfAllocArray<char>(point_size * num_points));
+	LazPerf_SizedBuffer buffer{};
+
+	decompressor.decompressMany(decompressed_points.get(), num_points);
+	buffer.data = decompressed_points.release();
+	buffer.size = point_size * num_points;
+	return buffer;
+}
+
+LazPerf_BufferResult lazperf_decompress_points(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		const char *lazsip_vlr_data,
+		size_t num_points,
+		size_t point_size)
+{
+	LazPerf_BufferResult result{};
+	try
+	{
+		LazPerf_SizedBuffer points = _lazperf_decompress_points(
+				compressed_points_buffer, buffer_size, lazsip_vlr_data, num_points, point_size);
+		result.is_error = 0;
+		result.points_buffer = points;
+	} catch (std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("unknown error");
+	}
+	return result;
+}
+
+//TODO Error VoidResult
+void lazperf_decompress_points_into(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		const char *lazsip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		uint8_t *out_buffer
+)
+{
+	VlrDecompressor decompressor(compressed_points_buffer, buffer_size, point_size, lazsip_vlr_data);
+	try
+	{
+		decompressor.decompressMany((char *) out_buffer, num_points);
+	} catch (const std::exception &e)
+	{
+		std::cout << e.what() << '\n';
+	}
+	catch (...)
+	{
+		std::cout << "Unknown Error\n";
+	}
+}
+
+static void _lazperf_decompress_points_parallel(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *lazsip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		uint8_t *out_buffer,
+		size_t num_threads)
+{
+	laszip::io::laz_vlr zipvlr(lazsip_vlr_data);
+	Schema schema = schemaFromVlr(lazsip_vlr_data, point_size);
+	std::vector<ChunkInfo> chunks = readChunkTable(
+			compressed_points_buffer, buffer_size, chunk_table_offset, zipvlr.chunk_size, num_points);
+
+	parallelFor(chunks.size(), num_threads, [&](size_t i)
+	{
+		const ChunkInfo &chunk = chunks[i];
+		decompressChunk(
+				compressed_points_buffer + chunk.offset,
+				chunk_table_offset - chunk.offset,
+				schema,
+				chunk.pointCount,
+				reinterpret_cast<char *>(out_buffer) + chunk.firstPoint * point_size);
+	});
+}
+
+LazPerf_VoidResult lazperf_decompress_points_parallel(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *lazsip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		uint8_t *out_buffer,
+		size_t num_threads)
+{
+	return makeVoidResult([&]()
+	{
+		_lazperf_decompress_points_parallel(
+				compressed_points_buffer, buffer_size, chunk_table_offset, lazsip_vlr_data,
+				num_points, point_size, out_buffer, num_threads);
+	});
+}
+
+/**
+ * Runs 'fn' and reports the errors of the jobs of a batch, an error that is not tied to a job fails them all
+ */
+template<typename Fn>
+static LazPerf_VoidResult makeBatchResult(BatchErrors &errors, Fn fn)
+{
+	try
+	{
+		fn();
+	}
+	catch (const std::exception &e)
+	{
+		errors.failRemaining(e.what());
+	}
+	catch (...)
+	{
+		errors.failRemaining("Unknown error");
+	}
+	return makeVoidResult([&]()
+	{
+		errors.check();
+	});
+}
+
+static void _lazperf_decompress_batch(
+		const LazPerf_DecompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		BatchErrors &errors)
+{
+	std::vector<Schema> schemas(num_jobs);
+	std::vector<std::vector<ChunkInfo>> chunk_tables(num_jobs);
+	parallelFor(num_jobs, num_threads, [&](size_t i)
+	{
+		errors.run(i, [&]()
+		{
+			const LazPerf_DecompressJob &job = jobs[i];
+			laszip::io::laz_vlr zipvlr(job.laszip_vlr_data);
+			schemas[i] = schemaFromVlr(job.laszip_vlr_data, job.point_size);
+			chunk_tables[i] = readChunkTable(
+					job.compressed_points_buffer, job.buffer_size, job.chunk_table_offset,
+					zipvlr.chunk_size, job.num_points);
+		});
+	});
+
+	std::vector<BatchTask> tasks;
+	for (size_t i = 0; i < num_jobs; ++i)
+	{
+		for (size_t j = 0; j < chunk_tables[i].size() && !errors.failed(i); ++j)
+		{
+			tasks.push_back({i, j, chunk_tables[i][j].pointCount * jobs[i].point_size});
+		}
+	}
+	sortTasksByCost(tasks);
+
+	parallelFor(tasks.size(), num_threads, [&](size_t i)
+	{
+		const BatchTask &task = tasks[i];
+		errors.run(task.job, [&]()
+		{
+			const LazPerf_DecompressJob &job = jobs[task.job];
+			const ChunkInfo &chunk = chunk_tables[task.job][task.chunk];
+			decompressChunk(
+					job.compressed_points_buffer + chunk.offset,
+					job.chunk_table_offset - chunk.offset,
+					schemas[task.job],
+					chunk.pointCount,
+					reinterpret_cast<char *>(job.out_buffer) + chunk.firstPoint * job.point_size);
+		});
+	});
+}
+
+LazPerf_VoidResult lazperf_decompress_batch(
+		const struct LazPerf_DecompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		struct LazPerf_VoidResult *job_results)
+{
+	BatchErrors errors(num_jobs);
+	LazPerf_VoidResult result = makeBatchResult(errors, [&]()
+	{
+		_lazperf_decompress_batch(jobs, num_jobs, num_threads, errors);
+	});
+
+	if (job_results)
+	{
+		for (size_t i = 0; i < num_jobs; ++i)
+		{
+			job_results[i] = LazPerf_VoidResult{};
+			if (errors.failed(i))
+			{
+				job_results[i].is_error = 1;
+				job_results[i].error.error_msg = lazperfStrdup(errors.message(i).c_str());
+			}
+		}
+	}
+	return result;
+}
+
+uint64_t lazperf_read_chunk_table_offset(const uint8_t *point_data, size_t offset_to_point_data)
+{
+	int64_t chunk_table_offset;
+	std::memcpy(&chunk_table_offset, point_data, sizeof(int64_t));
+	chunk_table_offset = (int64_t) le64toh(chunk_table_offset);
+
+	uint64_t points_start = offset_to_point_data + sizeof(uint64_t);
+	if (chunk_table_offset < 0 || (uint64_t) chunk_table_offset < points_start)
+	{
+		return UINT64_MAX;
+	}
+	return (uint64_t) chunk_table_offset - points_start;
+}
+
+static LazPerf_ChunkTable _lazperf_read_chunk_table(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *laszip_vlr_data,
+		size_t num_points)
+{
+	laszip::io::laz_vlr zipvlr(laszip_vlr_data);
+	std::vector<ChunkInfo> chunks = readChunkTable(
+			compressed_points_buffer, buffer_size, chunk_table_offset, zipvlr.chunk_size, num_points);
+
+	LazPerfArray<LazPerf_ChunkInfo> infos(lazperfAllocArray<LazPerf_ChunkInfo>(chunks.size()));
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		infos[i].offset = chunks[i].offset;
+		infos[i].compressed_size = chunks[i].byteCount;
+		infos[i].point_count = chunks[i].pointCount;
+		infos[i].first_point = chunks[i].firstPoint;
+	}
+
+	LazPerf_ChunkTable chunk_table{};
+	chunk_table.num_chunks = chunks.size();
+	chunk_table.chunks = infos.release();
+	return chunk_table;
+}
+
+LazPerf_ChunkTableResult lazperf_read_chunk_table(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *laszip_vlr_data,
+		size_t num_points)
+{
+	LazPerf_ChunkTableResult result{};
+	try
+	{
+		result.chunk_table = _lazperf_read_chunk_table(
+				compressed_points_buffer, buffer_size, chunk_table_offset, laszip_vlr_data, num_points);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_chunk_table(struct LazPerf_ChunkTable chunk_table)
+{
+	lazperfFree(chunk_table.chunks);
+}
+
+void lazperf_delete_chunk_table_result(struct LazPerf_ChunkTableResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+	else
+	{
+		lazperf_delete_chunk_table(result->chunk_table);
+	}
+}
+
+/**
+ * Size of the record data of a laszip vlr
+ */
+static size_t laszipVlrSize(const char *vlrData)
+{
+	auto data = reinterpret_cast<const uint8_t *>(vlrData);
+	return LASZIP_VLR_ITEMS + LASZIP_VLR_ITEM_SIZE * (size_t) readLe<uint16_t>(data + LASZIP_VLR_NUM_ITEMS);
+}
+
+/**
+ * Whether the points compressed with both vlrs can be stored together, that is, whether they only differ
+ * by their chunk size and their special evlrs (which are not about the points)
+ */
+static bool laszipVlrsCompatible(const char *lhs, const char *rhs)
+{
+	size_t size = laszipVlrSize(lhs);
+	return size == laszipVlrSize(rhs)
+		   && std::memcmp(lhs, rhs, LASZIP_VLR_CHUNK_SIZE) == 0
+		   && std::memcmp(lhs + LASZIP_VLR_NUM_ITEMS, rhs + LASZIP_VLR_NUM_ITEMS, size - LASZIP_VLR_NUM_ITEMS) == 0;
+}
+
+static LazPerf_MergedPoints _lazperf_merge_points(
+		const LazPerf_MergeInput *inputs,
+		size_t num_inputs,
+		size_t offset_to_point_data)
+{
+	if (num_inputs == 0)
+	{
+		throw std::runtime_error("There are no points to merge");
+	}
+
+	std::vector<std::vector<ChunkInfo>> chunk_tables(num_inputs);
+	uint32_t chunk_size = readLe<uint32_t>(
+			reinterpret_cast<const uint8_t *>(inputs[0].laszip_vlr_data) + LASZIP_VLR_CHUNK_SIZE);
+	if (chunk_size == 0)
+	{
+		throw std::runtime_error("Invalid chunk size in the laszip vlr");
+	}
+	bool variable = chunk_size == VARIABLE_CHUNK_SIZE;
+	for (size_t i = 0; i < num_inputs; ++i)
+	{
+		const LazPerf_MergeInput &input = inputs[i];
+		if (!laszipVlrsCompatible(inputs[0].laszip_vlr_data, input.laszip_vlr_data))
+		{
+			throw std::runtime_error("The points to merge were not compressed with the same laszip vlr");
+		}
+		laszip::io::laz_vlr zipvlr(input.laszip_vlr_data);
+		chunk_tables[i] = readChunkTable(
+				input.compressed_points_buffer, input.buffer_size, input.chunk_table_offset,
+				zipvlr.chunk_size, input.num_points);
+
+		// Fixed size chunks can only be kept if all chunks but the very last one are full
+		bool last_input = i + 1 == num_inputs;
+		variable = variable || zipvlr.chunk_size != chunk_size || (!last_input && input.num_points % chunk_size != 0);
+	}
+
+	std::vector<uint32_t> chunk_sizes;
+	std::vector<uint32_t> chunk_point_counts;
+	uint64_t chunk_table_pos = sizeof(uint64_t);
+	for (const std::vector<ChunkInfo> &chunks : chunk_tables)
+	{
+		for (const ChunkInfo &chunk : chunks)
+		{
+			chunk_sizes.push_back((uint32_t) chunk.byteCount);
+			chunk_point_counts.push_back((uint32_t) chunk.pointCount);
+			chunk_table_pos += chunk.byteCount;
+		}
+	}
+	if (!variable)
+	{
+		chunk_point_counts.clear();
+	}
+
+	ByteBuffer chunk_table;
+	TypedLazPerfBuf<uint8_t> chunk_table_stream(chunk_table);
+	writeChunkTable(chunk_table_stream, chunk_sizes, chunk_point_counts);
+
+	// The chunks of each input are contiguous, so they are copied at once
+	ResultBuffer points;
+	uint64_t offset_to_chunk_table = htole64(chunk_table_pos + offset_to_point_data);
+	points.append(reinterpret_cast<const char *>(&offset_to_chunk_table), sizeof(uint64_t));
+	for (size_t i = 0; i < num_inputs; ++i)
+	{
+		const std::vector<ChunkInfo> &chunks = chunk_tables[i];
+		if (!chunks.empty())
+		{
+			uint64_t num_bytes = chunks.back().offset + chunks.back().byteCount - chunks.front().offset;
+			points.append(
+					reinterpret_cast<const char *>(inputs[i].compressed_points_buffer + chunks.front().offset),
+					(size_t) num_bytes);
+		}
+	}
+	points.append(reinterpret_cast<const char *>(chunk_table.data()), chunk_table.size());
+
+	ResultBuffer vlr_data;
+	vlr_data.append(inputs[0].laszip_vlr_data, laszipVlrSize(inputs[0].laszip_vlr_data));
+
+	LazPerf_MergedPoints merged{};
+	merged.points_buffer = points.release();
+	merged.laszip_vlr_data = vlr_data.release();
+	writeLe<uint32_t>(
+			reinterpret_cast<uint8_t *>(merged.laszip_vlr_data.data) + LASZIP_VLR_CHUNK_SIZE,
+			variable ? VARIABLE_CHUNK_SIZE : chunk_size);
+	return merged;
+}
+
+LazPerf_MergeResult lazperf_merge_points(
+		const struct LazPerf_MergeInput *inputs,
+		size_t num_inputs,
+		size_t offset_to_point_data)
+{
+	LazPerf_MergeResult result{};
+	try
+	{
+		result.merged = _lazperf_merge_points(inputs, num_inputs, offset_to_point_data);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_merge_result(struct LazPerf_MergeResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+	else
+	{
+		lazperfFree(result->merged.points_buffer.data);
+		lazperfFree(result->merged.laszip_vlr_data.data);
+	}
+}
+
+
+LazPerf_VlrDecompressorPtr lazperf_new_vlr_decompressor(
+		const uint8_t *compressed_buffer,
+		size_t buffer_size,
+		size_t point_size,
+		const char *laszip_vlr_data
+)
+{
+	auto decompressor = new VlrDecompressor(compressed_buffer, buffer_size, point_size, laszip_vlr_data);
+	return reinterpret_cast<void *>(decompressor);
+}
+
+LazPerf_VlrDecompressorPtr lazperf_new_vlr_decompressor_from_source(
+		LazPerf_ReadCallback read_callback,
+		void *user_data,
+		size_t buffer_size,
+		size_t point_size,
+		const char *laszip_vlr_data
+)
+{
+	auto decompressor = new VlrDecompressor(read_callback, user_data, buffer_size, point_size, laszip_vlr_data);
+	return reinterpret_cast<void *>(decompressor);
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_reset(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const uint8_t *compressed_buffer,
+		size_t buffer_size)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->reset(compressed_buffer, buffer_size);
+	});
+}
+
+/**
+ * Calls 'fn', which creates a decompressor, and turns any exception it throws into an error result
+ */
+template<typename TResult, typename Fn>
+static TResult makeDecompressorResult(Fn fn)
+{
+	TResult result{};
+	try
+	{
+		result.decompressor = reinterpret_cast<void *>(fn());
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+LazPerf_PrefetchingDecompressorResult lazperf_new_prefetching_decompressor(
+		const uint8_t *compressed_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *laszip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		size_t num_threads,
+		size_t num_buffers
+)
+{
+	return makeDecompressorResult<LazPerf_PrefetchingDecompressorResult>([&]()
+	{
+		return new PrefetchingDecompressor(compressed_buffer, buffer_size, chunk_table_offset, laszip_vlr_data,
+										   num_points, point_size, num_threads, num_buffers);
+	});
+}
+
+void lazperf_delete_prefetching_decompressor_result(struct LazPerf_PrefetchingDecompressorResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+}
+
+LazPerf_SizeResult lazperf_prefetching_decompressor_next_chunk(
+		LazPerf_PrefetchingDecompressorPtr decompressor,
+		const char **points)
+{
+	auto prefetching_decompressor = reinterpret_cast<PrefetchingDecompressor *>(decompressor);
+	LazPerf_SizeResult result{};
+	try
+	{
+		result.size = prefetching_decompressor->nextChunk(points);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_prefetching_decompressor(LazPerf_PrefetchingDecompressorPtr decompressor)
+{
+	delete reinterpret_cast<PrefetchingDecompressor *>(decompressor);
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_enable_stats(
+		LazPerf_VlrDecompressorPtr decompressor,
+		int measure_item_bytes)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->enableStats(measure_item_bytes != 0);
+	});
+}
+
+LazPerf_Stats lazperf_vlr_decompressor_stats(LazPerf_VlrDecompressorPtr decompressor)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return vlr_decompressor->stats();
+}
+
+void lazperf_delete_vlr_decompressor(LazPerf_VlrDecompressorPtr decompressor)
+{
+	delete reinterpret_cast<VlrDecompressor *>(decompressor);
+}
+
+void lazperf_delete_vlr_decompressor_result(struct LazPerf_VlrDecompressorResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+}
+
+void lazperf_vlr_decompressor_decompress_one_to(LazPerf_VlrDecompressorPtr decompressor, char *out)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	vlr_decompressor->decompress(out);
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_decompress_many(
+		LazPerf_VlrDecompressorPtr decompressor,
+		size_t num_points,
+		char *out)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->decompressMany(out, num_points);
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_read_chunk_table(
+		LazPerf_VlrDecompressorPtr decompressor,
+		uint64_t chunk_table_offset,
+		size_t num_points)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->readChunkTable(chunk_table_offset, num_points);
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_seek(LazPerf_VlrDecompressorPtr decompressor, size_t point_index)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->seek(point_index);
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_decompress_columns(
+		LazPerf_VlrDecompressorPtr decompressor,
+		size_t num_points,
+		const double scales[3],
+		const double offsets[3],
+		const struct LazPerf_Columns *columns)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->decompressColumns(num_points, scales, offsets, *columns);
+	});
+}
+
+size_t lazperf_vlr_decompressor_num_chunks(LazPerf_VlrDecompressorPtr decompressor)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return vlr_decompressor->numChunks();
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_compute_chunk_bounds(
+		LazPerf_VlrDecompressorPtr decompressor,
+		struct LazPerf_Bounds *bounds)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		const std::vector<LazPerf_Bounds> &chunk_bounds = vlr_decompressor->computeChunkBounds();
+		if (bounds)
+		{
+			std::copy(chunk_bounds.begin(), chunk_bounds.end(), bounds);
+		}
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_decompressor_set_chunk_bounds(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const struct LazPerf_Bounds *bounds,
+		size_t num_chunks)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	return makeVoidResult([&]()
+	{
+		vlr_decompressor->setChunkBounds(bounds, num_chunks);
+	});
+}
+
+LazPerf_BufferResult lazperf_vlr_decompressor_query_box(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const struct LazPerf_Bounds *box)
+{
+	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
+	LazPerf_BufferResult result{};
+	try
+	{
+		ResultBuffer points;
+		vlr_decompressor->queryBox(*box, points);
+		result.points_buffer = points.release();
+		result.is_error = 0;
 	}
-	buffer.data = decompressed_points.release();
-	buffer.size = point_size * num_points;
-	return buffer;
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
 }
 
-LazPerf_BufferResult lazperf_decompress_points(
-		const uint8_t *compressed_points_buffer,
-		size_t buffer_size,
-		const char *lazsip_vlr_data,
-		size_t num_points,
-		size_t point_size)
+LazPerf_ChunkIndexResult lazperf_parse_chunk_index(const uint8_t *data, size_t size)
+{
+	LazPerf_ChunkIndexResult result{};
+	try
+	{
+		result.chunk_index = parseChunkIndex(data, size);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_chunk_index(struct LazPerf_ChunkIndex chunk_index)
+{
+	lazperfFree(chunk_index.bounds);
+	lazperfFree(chunk_index.min_gps_times);
+	lazperfFree(chunk_index.max_gps_times);
+}
+
+void lazperf_delete_chunk_index_result(struct LazPerf_ChunkIndexResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+	else
+	{
+		lazperf_delete_chunk_index(result->chunk_index);
+	}
+}
+
+LazPerf_RecordSchemaPtr lazperf_new_record_schema(void)
+{
+	return reinterpret_cast<void *>(new laszip::factory::record_schema);
+}
+
+void lazperf_record_schema_push_point(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	record_schema->push(laszip::factory::record_item::point());
+}
+
+void lazperf_record_schema_push_gpstime(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	record_schema->push(laszip::factory::record_item::gpstime());
+}
+
+void lazperf_record_schema_push_rgb(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	record_schema->push(laszip::factory::record_item::rgb());
+}
+
+void lazperf_record_schema_push_extrabytes(LazPerf_RecordSchemaPtr schema, size_t count)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	record_schema->push(laszip::factory::record_item::eb(count));
+}
+
+int lazperf_record_schema_size_in_bytes(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	return record_schema->size_in_bytes();
+}
+
+void lazperf_delete_record_schema(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	delete record_schema;
+}
+
+struct LazPerf_SizedBuffer lazperf_record_schema_laz_vlr_data(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	auto vlr = laszip::io::laz_vlr::from_schema(*record_schema);
+
+	LazPerf_SizedBuffer raw_vlr_data{};
+	char *data = lazperfAllocArray<char>(vlr.size());
+	vlr.extract(data);
+	raw_vlr_data.size = vlr.size();
+	raw_vlr_data.data = data;
+	return raw_vlr_data;
+}
+
+LazPerf_LazVlrPtr lazperf_new_laz_vlr_from_schema(LazPerf_RecordSchemaPtr schema)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	auto vlr = laszip::io::laz_vlr::from_schema(*record_schema);
+	auto *vlr_on_heap = new laszip::io::laz_vlr;
+	*vlr_on_heap = vlr;
+
+	return reinterpret_cast<void *>(vlr_on_heap);
+}
+
+void lazperf_delete_laz_vlr(LazPerf_LazVlrPtr vlr)
+{
+	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
+	delete vlr_;
+}
+
+size_t lazperf_laz_vlr_record_data_size(LazPerf_RecordSchemaPtr vlr)
+{
+	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
+	return vlr_->size();
+}
+
+void lazperf_laz_vlr_copy_record_data(LazPerf_LazVlrPtr vlr, char *out)
+{
+	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
+	vlr_->extract(out);
+}
+
+LazPerf_VoidResult lazperf_laz_vlr_set_chunk_size(LazPerf_LazVlrPtr vlr, uint32_t chunk_size)
+{
+	return makeVoidResult([&]()
+	{
+		checkChunkSize(chunk_size);
+		reinterpret_cast<laszip::io::laz_vlr *>(vlr)->chunk_size = chunk_size;
+	});
+}
+
+/* LAZ file reader */
+
+LazPerf_FileReaderResult lazperf_open_file(const char *path)
+{
+	LazPerf_FileReaderResult result{};
+	try
+	{
+		result.reader = reinterpret_cast<void *>(new LazFileReader(path));
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_file_reader_result(struct LazPerf_FileReaderResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+}
+
+void lazperf_close_file(LazPerf_FileReaderPtr reader)
+{
+	delete reinterpret_cast<LazFileReader *>(reader);
+}
+
+const struct LazPerf_LasHeader *lazperf_file_reader_header(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return &file_reader->header();
+}
+
+size_t lazperf_file_reader_point_count(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return file_reader->header().point_count;
+}
+
+size_t lazperf_file_reader_point_size(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return file_reader->header().point_size;
+}
+
+const char *lazperf_file_reader_laszip_vlr_data(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return file_reader->laszipVlrData();
+}
+
+const uint8_t *lazperf_file_reader_compressed_points(LazPerf_FileReaderPtr reader, size_t *size)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	*size = file_reader->pointsSize();
+	return file_reader->points();
+}
+
+uint64_t lazperf_file_reader_chunk_table_offset(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return file_reader->chunkTableOffset();
+}
+
+void lazperf_file_reader_advise(LazPerf_FileReaderPtr reader, enum LazPerf_AccessPattern access_pattern)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	switch (access_pattern)
+	{
+		case LAZPERF_ACCESS_SEQUENTIAL:
+			file_reader->advise(MappedFile::Access::Sequential);
+			break;
+		case LAZPERF_ACCESS_RANDOM:
+			file_reader->advise(MappedFile::Access::Random);
+			break;
+		case LAZPERF_ACCESS_WILLNEED:
+			file_reader->advise(MappedFile::Access::WillNeed);
+			break;
+		default:
+			file_reader->advise(MappedFile::Access::Normal);
+			break;
+	}
+}
+
+LazPerf_VlrDecompressorResult lazperf_file_reader_new_decompressor(LazPerf_FileReaderPtr reader)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return makeDecompressorResult<LazPerf_VlrDecompressorResult>([&]()
+	{
+		return file_reader->newDecompressor();
+	});
+}
+
+LazPerf_PrefetchingDecompressorResult lazperf_file_reader_new_prefetching_decompressor(
+		LazPerf_FileReaderPtr reader,
+		size_t num_threads,
+		size_t num_buffers)
+{
+	auto file_reader = reinterpret_cast<LazFileReader *>(reader);
+	return makeDecompressorResult<LazPerf_PrefetchingDecompressorResult>([&]()
+	{
+		if (file_reader->chunkTableOffset() == UINT64_MAX)
+		{
+			throw std::runtime_error("The file has no chunk table");
+		}
+		return new PrefetchingDecompressor(
+				file_reader->points(), file_reader->pointsSize(), file_reader->chunkTableOffset(),
+				file_reader->laszipVlrData(), file_reader->header().point_count, file_reader->header().point_size,
+				num_threads, num_buffers);
+	});
+}
+
+/* LAZ file writer */
+
+LazPerf_FileWriterResult lazperf_create_file(
+		const char *path,
+		LazPerf_RecordSchemaPtr schema,
+		const struct LazPerf_LasHeader *header)
+{
+	LazPerf_FileWriterResult result{};
+	try
+	{
+		auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+		result.writer = reinterpret_cast<void *>(new LazFileWriter(path, *record_schema, *header));
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
+void lazperf_delete_file_writer_result(struct LazPerf_FileWriterResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+}
+
+LazPerf_VoidResult lazperf_file_writer_add_vlr(
+		LazPerf_FileWriterPtr writer,
+		const char *user_id,
+		uint16_t record_id,
+		const char *description,
+		const uint8_t *data,
+		size_t size)
+{
+	auto file_writer = reinterpret_cast<LazFileWriter *>(writer);
+	return makeVoidResult([&]()
+	{
+		file_writer->addVlr(user_id, record_id, description, data, size);
+	});
+}
+
+LazPerf_VoidResult lazperf_file_writer_set_chunk_size(LazPerf_FileWriterPtr writer, uint32_t chunk_size)
+{
+	auto file_writer = reinterpret_cast<LazFileWriter *>(writer);
+	return makeVoidResult([&]()
+	{
+		file_writer->setChunkSize(chunk_size);
+	});
+}
+
+LazPerf_VoidResult lazperf_file_writer_write_points(
+		LazPerf_FileWriterPtr writer,
+		const char *points,
+		size_t num_points)
+{
+	auto file_writer = reinterpret_cast<LazFileWriter *>(writer);
+	return makeVoidResult([&]()
+	{
+		file_writer->writePoints(points, num_points);
+	});
+}
+
+LazPerf_VoidResult lazperf_file_writer_finish(LazPerf_FileWriterPtr writer)
+{
+	auto file_writer = reinterpret_cast<LazFileWriter *>(writer);
+	return makeVoidResult([&]()
+	{
+		file_writer->finish();
+	});
+}
+
+void lazperf_delete_file_writer(LazPerf_FileWriterPtr writer)
+{
+	delete reinterpret_cast<LazFileWriter *>(writer);
+}
+
+/* Compression */
+
+LazPerf_BufferResult
+lazperf_compress_points(LazPerf_RecordSchemaPtr schema, size_t offset_to_point_data, const char *points,
+						size_t num_points)
 {
 	LazPerf_BufferResult result{};
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
 	try
 	{
-		LazPerf_SizedBuffer points = _lazperf_decompress_points(
-				compressed_points_buffer, buffer_size, lazsip_vlr_data, num_points, point_size);
 		result.is_error = 0;
-		result.points_buffer = points;
-	} catch (std::exception &e)
+		VlrCompressor vlr_compressor(*record_schema);
+		vlr_compressor.compressMany(points, num_points);
+
+		uint64_t chunk_table_pos = vlr_compressor.done();
+		chunk_table_pos += offset_to_point_data;
+		vlr_compressor.writeChunkTable();
+		char *compressed_points = lazperfAllocArray<char>(vlr_compressor.data()->size());
+		vlr_compressor.copyDataTo(reinterpret_cast<uint8_t *>(compressed_points));
+		std::memcpy(compressed_points, &chunk_table_pos, sizeof(uint64_t));
+		result.points_buffer.size = vlr_compressor.data()->size();
+		result.points_buffer.data = compressed_points;
+	}
+	catch (const std::exception &e)
 	{
 		result.is_error = 1;
-		result.error.error_msg = strdup(e.what());
+		result.error.error_msg = lazperfStrdup(e.what());
 	}
 	catch (...)
 	{
 		result.is_error = 1;
-		result.error.error_msg = strdup("unknown error");
+		result.error.error_msg = lazperfStrdup("Unknown error");
 	}
 	return result;
 }
 
-//TODO Error VoidResult
-void lazperf_decompress_points_into(
-		const uint8_t *compressed_points_buffer,
-		size_t buffer_size,
-		const char *lazsip_vlr_data,
-		size_t num_points,
-		size_t point_size,
-		uint8_t *out_buffer
-)
+/**
+ * Concatenates chunks compressed separately into a buffer of compressed points,
+ * with the offset to the chunk table and the chunk table. The chunks are freed as they are copied.
+ */
+static LazPerf_SizedBuffer concatenateChunks(std::vector<ByteBuffer> &chunks, size_t offset_to_point_data)
 {
-	VlrDecompressor decompressor(compressed_points_buffer, buffer_size, point_size, lazsip_vlr_data);
-	try
-	{
-		char *current_point = (char *) out_buffer;
-		for (size_t i = 0; i < num_points; ++i)
-		{
-			decompressor.decompress(current_point);
-			current_point += point_size;
-		}
-	} catch (const std::exception &e)
+	size_t num_chunks = chunks.size();
+	std::vector<uint32_t> chunk_sizes;
+	chunk_sizes.reserve(num_chunks);
+	uint64_t chunk_table_pos = sizeof(uint64_t);
+	for (const ByteBuffer &chunk : chunks)
 	{
-		std::cout << e.what() << '\n';
+		chunk_sizes.push_back((uint32_t) chunk.size());
+		chunk_table_pos += chunk.size();
 	}
-	catch (...)
+
+	ByteBuffer chunk_table;
+	TypedLazPerfBuf<uint8_t> chunk_table_stream(chunk_table);
+	writeChunkTable(chunk_table_stream, chunk_sizes);
+
+	LazPerf_SizedBuffer buffer{};
+	buffer.size = chunk_table_pos + chunk_table.size();
+	LazPerfArray<char> compressed_points(lazperfAllocArray<char>(buffer.size));
+
+	uint64_t offset_to_chunk_table = htole64(chunk_table_pos + offset_to_point_data);
+	std::memcpy(compressed_points.get(), &offset_to_chunk_table, sizeof(uint64_t));
+	char *current = compressed_points.get() + sizeof(uint64_t);
+	for (ByteBuffer &chunk : chunks)
 	{
-		std::cout << "Unknown Error\n";
+		std::memcpy(current, chunk.data(), chunk.size());
+		current += chunk.size();
+		ByteBuffer().swap(chunk);
 	}
-}
+	std::memcpy(current, chunk_table.data(), chunk_table.size());
 
-
-LazPerf_VlrDecompressorPtr lazperf_new_vlr_decompressor(
-		const uint8_t *compressed_buffer,
-		size_t buffer_size,
-		size_t point_size,
-		const char *laszip_vlr_data
-)
-{
-	auto decompressor = new VlrDecompressor(compressed_buffer, buffer_size, point_size, laszip_vlr_data);
-	return reinterpret_cast<void *>(decompressor);
+	buffer.data = compressed_points.release();
+	return buffer;
 }
 
-void lazperf_delete_vlr_decompressor(LazPerf_VlrDecompressorPtr decompressor)
+/**
+ * Number of points per chunk of the whole buffer compressions, 0 meaning the default of the laszip vlr
+ */
+static uint32_t resolveChunkSize(const Schema &schema, uint32_t chunk_size)
 {
-	delete reinterpret_cast<VlrDecompressor *>(decompressor);
+	if (chunk_size == 0)
+	{
+		return laszip::io::laz_vlr::from_schema(schema).chunk_size;
+	}
+	checkChunkSize(chunk_size);
+	return chunk_size;
 }
 
-void lazperf_vlr_decompressor_decompress_one_to(LazPerf_VlrDecompressorPtr decompressor, char *out)
+static LazPerf_SizedBuffer _lazperf_compress_points_parallel(
+		const Schema &schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t points_per_chunk,
+		size_t num_threads)
 {
-	auto vlr_decompressor = reinterpret_cast<VlrDecompressor *>(decompressor);
-	vlr_decompressor->decompress(out);
-}
+	uint64_t chunk_size = resolveChunkSize(schema, points_per_chunk);
+	size_t point_size = (size_t) schema.size_in_bytes();
+	size_t num_chunks = (size_t) ((num_points + chunk_size - 1) / chunk_size);
 
-LazPerf_RecordSchemaPtr lazperf_new_record_schema(void)
-{
-	return reinterpret_cast<void *>(new laszip::factory::record_schema);
-}
+	std::vector<ByteBuffer> chunks(num_chunks);
+	parallelFor(num_chunks, num_threads, [&](size_t i)
+	{
+		uint64_t first_point = i * chunk_size;
+		uint64_t chunk_points = std::min<uint64_t>(chunk_size, num_points - first_point);
+		TypedLazPerfBuf<uint8_t> stream(chunks[i]);
+		compressChunk(stream, schema, points + first_point * point_size, chunk_points);
+	});
 
-void lazperf_record_schema_push_point(LazPerf_RecordSchemaPtr schema)
-{
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	record_schema->push(laszip::factory::record_item::point());
+	return concatenateChunks(chunks, offset_to_point_data);
 }
 
-void lazperf_record_schema_push_gpstime(LazPerf_RecordSchemaPtr schema)
+LazPerf_BufferResult lazperf_compress_points_parallel(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t chunk_size,
+		size_t num_threads)
 {
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	record_schema->push(laszip::factory::record_item::gpstime());
-}
+	if (num_points == 0)
+	{
+		return lazperf_compress_points(schema, offset_to_point_data, points, num_points);
+	}
 
-void lazperf_record_schema_push_rgb(LazPerf_RecordSchemaPtr schema)
-{
+	LazPerf_BufferResult result{};
 	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	record_schema->push(laszip::factory::record_item::rgb());
+	try
+	{
+		result.points_buffer = _lazperf_compress_points_parallel(
+				*record_schema, offset_to_point_data, points, num_points, chunk_size, num_threads);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
 }
 
-void lazperf_record_schema_push_extrabytes(LazPerf_RecordSchemaPtr schema, size_t count)
+static void _lazperf_compress_batch(
+		const LazPerf_CompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		BatchErrors &errors,
+		std::vector<LazPerf_SizedBuffer> &outputs)
 {
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	record_schema->push(laszip::factory::record_item::eb(count));
-}
+	std::vector<const Schema *> schemas(num_jobs);
+	std::vector<uint64_t> chunk_sizes(num_jobs);
+	std::vector<std::vector<ByteBuffer>> chunks(num_jobs);
+	std::vector<BatchTask> tasks;
+	for (size_t i = 0; i < num_jobs; ++i)
+	{
+		const LazPerf_CompressJob &job = jobs[i];
+		if (job.num_points == 0)
+		{
+			// Nothing to split, the serial path writes the empty chunk table
+			LazPerf_BufferResult result = lazperf_compress_points(
+					job.schema, job.offset_to_point_data, job.points, job.num_points);
+			if (result.is_error)
+			{
+				errors.fail(i, result.error.error_msg ? result.error.error_msg : "Unknown error");
+				lazperf_delete_result(&result);
+			}
+			else
+			{
+				outputs[i] = result.points_buffer;
+			}
+			continue;
+		}
 
-int lazperf_record_schema_size_in_bytes(LazPerf_RecordSchemaPtr schema)
-{
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	return record_schema->size_in_bytes();
-}
+		errors.run(i, [&]()
+		{
+			schemas[i] = reinterpret_cast<const Schema *>(job.schema);
+			chunk_sizes[i] = resolveChunkSize(*schemas[i], job.chunk_size);
+			size_t num_chunks = (size_t) ((job.num_points + chunk_sizes[i] - 1) / chunk_sizes[i]);
+			size_t point_size = (size_t) schemas[i]->size_in_bytes();
+			chunks[i].resize(num_chunks);
+			for (size_t j = 0; j < num_chunks; ++j)
+			{
+				uint64_t chunk_points = std::min<uint64_t>(chunk_sizes[i], job.num_points - j * chunk_sizes[i]);
+				tasks.push_back({i, j, chunk_points * point_size});
+			}
+		});
+	}
+	sortTasksByCost(tasks);
 
-void lazperf_delete_record_schema(LazPerf_RecordSchemaPtr schema)
-{
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	delete record_schema;
+	parallelFor(tasks.size(), num_threads, [&](size_t i)
+	{
+		const BatchTask &task = tasks[i];
+		errors.run(task.job, [&]()
+		{
+			const LazPerf_CompressJob &job = jobs[task.job];
+			const Schema &schema = *schemas[task.job];
+			uint64_t first_point = task.chunk * chunk_sizes[task.job];
+			uint64_t chunk_points = std::min<uint64_t>(chunk_sizes[task.job], job.num_points - first_point);
+			TypedLazPerfBuf<uint8_t> stream(chunks[task.job][task.chunk]);
+			compressChunk(stream, schema, job.points + first_point * (size_t) schema.size_in_bytes(), chunk_points);
+		});
+	});
+
+	parallelFor(num_jobs, num_threads, [&](size_t i)
+	{
+		if (jobs[i].num_points != 0)
+		{
+			errors.run(i, [&]()
+			{
+				outputs[i] = concatenateChunks(chunks[i], jobs[i].offset_to_point_data);
+			});
+		}
+		std::vector<ByteBuffer>().swap(chunks[i]);
+	});
 }
 
-struct LazPerf_SizedBuffer lazperf_record_schema_laz_vlr_data(LazPerf_RecordSchemaPtr schema)
+LazPerf_VoidResult lazperf_compress_batch(
+		const struct LazPerf_CompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		struct LazPerf_BufferResult *job_results)
 {
-	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	auto vlr = laszip::io::laz_vlr::from_schema(*record_schema);
+	BatchErrors errors(num_jobs);
+	std::vector<LazPerf_SizedBuffer> outputs(num_jobs);
+	LazPerf_VoidResult result = makeBatchResult(errors, [&]()
+	{
+		_lazperf_compress_batch(jobs, num_jobs, num_threads, errors, outputs);
+	});
 
-	LazPerf_SizedBuffer raw_vlr_data{};
-	char *data = new char[vlr.size()];
-	vlr.extract(data);
-	raw_vlr_data.size = vlr.size();
-	raw_vlr_data.data = data;
-	return raw_vlr_data;
+	for (size_t i = 0; i < num_jobs; ++i)
+	{
+		job_results[i] = LazPerf_BufferResult{};
+		if (errors.failed(i))
+		{
+			lazperfFree(outputs[i].data);
+			job_results[i].is_error = 1;
+			job_results[i].error.error_msg = lazperfStrdup(errors.message(i).c_str());
+		}
+		else
+		{
+			job_results[i].points_buffer = outputs[i];
+		}
+	}
+	return result;
 }
 
-LazPerf_LazVlrPtr lazperf_new_laz_vlr_from_schema(LazPerf_RecordSchemaPtr schema)
+size_t lazperf_compress_bound(LazPerf_RecordSchemaPtr schema, size_t num_points, uint32_t chunk_size)
 {
 	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	auto vlr = laszip::io::laz_vlr::from_schema(*record_schema);
-	auto *vlr_on_heap = new laszip::io::laz_vlr;
-	*vlr_on_heap = vlr;
-
-	return reinterpret_cast<void *>(vlr_on_heap);
+	size_t point_size = (size_t) record_schema->size_in_bytes();
+	if (chunk_size == 0)
+	{
+		chunk_size = laszip::io::laz_vlr::from_schema(*record_schema).chunk_size;
+	}
+	// Without points, there is still the empty chunk
+	size_t num_chunks = std::max<size_t>(1, (num_points + chunk_size - 1) / chunk_size);
+
+	// The encoder renormalizes so that its range never drops below 2^24 before a symbol is coded,
+	// and the models give every symbol at least 1 / 2^15 of the range (1 / 2^13 for bit models),
+	// so a symbol costs at most 16 bits. Every field coder spends at most 2 symbols per byte
+	// of its field (integers: 1 symbol for the number of corrector bits, 1 for the high bits,
+	// the low bits being written raw), plus one symbol telling which fields changed:
+	// that is at most 2 * point_size + 4 bytes per point. The first point of each chunk is
+	// stored raw, and the encoder flushes at most a few bytes when a chunk is closed.
+	size_t points_bound = num_points * (2 * point_size + 4) + num_chunks * (point_size + 16);
+	size_t chunk_table_bound = 2 * sizeof(uint32_t) + num_chunks * 8 + 16;
+	return sizeof(uint64_t) + points_bound + chunk_table_bound;
 }
 
-void lazperf_delete_laz_vlr(LazPerf_LazVlrPtr vlr)
+static size_t _lazperf_compress_points_into(
+		const Schema &schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t points_per_chunk,
+		uint8_t *out,
+		size_t out_capacity)
 {
-	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
-	delete vlr_;
-}
+	uint64_t chunk_size = resolveChunkSize(schema, points_per_chunk);
+	size_t point_size = (size_t) schema.size_in_bytes();
+	WriteOnlyStream stream(out, out_capacity);
 
-size_t lazperf_laz_vlr_record_data_size(LazPerf_RecordSchemaPtr vlr)
-{
-	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
-	return vlr_->size();
-}
+	// Skip over the chunk table offset, patched at the end
+	unsigned char skip[sizeof(uint64_t)] = {0};
+	stream.putBytes(skip, sizeof(skip));
 
-void lazperf_laz_vlr_copy_record_data(LazPerf_LazVlrPtr vlr, char *out)
-{
-	auto vlr_ = reinterpret_cast<laszip::io::laz_vlr *>(vlr);
-	vlr_->extract(out);
-}
+	std::vector<uint32_t> chunk_sizes;
+	for (uint64_t first_point = 0; first_point < num_points; first_point += chunk_size)
+	{
+		uint64_t chunk_points = std::min<uint64_t>(chunk_size, num_points - first_point);
+		size_t chunk_start = stream.totalWritten();
+		compressChunk(stream, schema, points + first_point * point_size, chunk_points);
+		chunk_sizes.push_back((uint32_t) (stream.totalWritten() - chunk_start));
+	}
+	if (num_points == 0)
+	{
+		// The single empty chunk VlrCompressor writes, so that the output is the one of lazperf_compress_points
+		chunk_sizes.push_back(0);
+	}
 
-/* Compression */
+	uint64_t offset_to_chunk_table = htole64(stream.totalWritten() + offset_to_point_data);
+	writeChunkTable(stream, chunk_sizes);
+	std::memcpy(out, &offset_to_chunk_table, sizeof(uint64_t));
+	return stream.totalWritten();
+}
 
-LazPerf_BufferResult
-lazperf_compress_points(LazPerf_RecordSchemaPtr schema, size_t offset_to_point_data, const char *points,
-						size_t num_points)
+LazPerf_SizeResult lazperf_compress_points_into(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t chunk_size,
+		uint8_t *out,
+		size_t out_capacity)
 {
-	LazPerf_BufferResult result{};
+	LazPerf_SizeResult result{};
 	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
-	size_t point_size = record_schema->size_in_bytes();
 	try
 	{
+		result.size = _lazperf_compress_points_into(
+				*record_schema, offset_to_point_data, points, num_points, chunk_size, out, out_capacity);
 		result.is_error = 0;
-		VlrCompressor vlr_compressor(*record_schema);
-		const char *current_point = points;
-		for (size_t i = 0; i < num_points; ++i)
-		{
-			vlr_compressor.compress(current_point);
-			current_point += point_size;
-		}
-
-		uint64_t chunk_table_pos = vlr_compressor.done();
-		chunk_table_pos += offset_to_point_data;
-		vlr_compressor.writeChunkTable();
-		char *compressed_points = new char[vlr_compressor.data()->size()];
-		vlr_compressor.copyDataTo(reinterpret_cast<uint8_t *>(compressed_points));
-		std::memcpy(compressed_points, &chunk_table_pos, sizeof(uint64_t));
-		result.points_buffer.size = vlr_compressor.data()->size();
-		result.points_buffer.data = compressed_points;
 	}
 	catch (const std::exception &e)
 	{
 		result.is_error = 1;
-		result.error.error_msg = strdup(e.what());
+		result.error.error_msg = lazperfStrdup(e.what());
 	}
 	catch (...)
 	{
 		result.is_error = 1;
-		result.error.error_msg = strdup("Unknown error");
+		result.error.error_msg = lazperfStrdup("Unknown error");
 	}
 	return result;
 }
@@ -492,6 +2978,20 @@ LazPerf_VlrCompressorPtr lazperf_new_vlr_compressor(
 	return reinterpret_cast<void *>(vlr_compressor);
 }
 
+LazPerf_VlrCompressorPtr lazperf_new_vlr_compressor_with_sink(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		LazPerf_WriteCallback write_callback,
+		LazPerf_PatchCallback patch_callback,
+		void *user_data
+)
+{
+	auto record_schema = reinterpret_cast<laszip::factory::record_schema *>(schema);
+	auto vlr_compressor = new VlrCompressor(*record_schema);
+	vlr_compressor->setSink(write_callback, patch_callback, user_data, offset_to_point_data);
+	return reinterpret_cast<void *>(vlr_compressor);
+}
+
 void lazperf_delete_vlr_compressor(LazPerf_VlrCompressorPtr compressor)
 {
 	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
@@ -513,6 +3013,31 @@ size_t lazperf_vlr_compressor_compress(LazPerf_VlrCompressorPtr compressor, cons
 	}
 }
 
+LazPerf_SizeResult lazperf_vlr_compressor_compress_many(
+		LazPerf_VlrCompressorPtr compressor,
+		size_t num_points,
+		const char *inbuf)
+{
+	LazPerf_SizeResult result{};
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	try
+	{
+		result.size = vlr_compressor->compressMany(inbuf, num_points);
+		result.is_error = 0;
+	}
+	catch (const std::exception &e)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup(e.what());
+	}
+	catch (...)
+	{
+		result.is_error = 1;
+		result.error.error_msg = lazperfStrdup("Unknown error");
+	}
+	return result;
+}
+
 size_t lazperf_vlr_compressor_copy_data_to(LazPerf_VlrCompressorPtr compressor, uint8_t *dst)
 {
 	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
@@ -543,7 +3068,7 @@ struct LazPerf_SizedBuffer lazperf_vlr_compressor_vlr_data(LazPerf_VlrCompressor
 
 	LazPerf_SizedBuffer vlr_data{};
 	vlr_data.size = vlr_compressor->vlrDataSize();
-	vlr_data.data = new char[vlr_data.size];
+	vlr_data.data = lazperfAllocArray<char>(vlr_data.size);
 	vlr_compressor->extractVlrData(vlr_data.data);
 	return vlr_data;
 }
@@ -560,6 +3085,89 @@ size_t lazperf_vlr_compressor_internal_buffer_size(LazPerf_VlrCompressorPtr comp
 	return vlr_compressor->data()->size();
 }
 
+LazPerf_VoidResult lazperf_vlr_compressor_enable_chunk_index(LazPerf_VlrCompressorPtr compressor)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->enableChunkIndex();
+	});
+}
+
+struct LazPerf_SizedBuffer lazperf_vlr_compressor_chunk_index_data(LazPerf_VlrCompressorPtr compressor)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+
+	LazPerf_SizedBuffer index_data{};
+	if (vlr_compressor->chunkIndex())
+	{
+		std::vector<uint8_t> data = vlr_compressor->chunkIndex()->serialize();
+		index_data.size = data.size();
+		index_data.data = lazperfAllocArray<char>(data.size());
+		std::copy(data.begin(), data.end(), index_data.data);
+	}
+	return index_data;
+}
+
+LazPerf_VoidResult lazperf_vlr_compressor_enable_stats(LazPerf_VlrCompressorPtr compressor, int measure_item_bytes)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->enableStats(measure_item_bytes != 0);
+	});
+}
+
+LazPerf_Stats lazperf_vlr_compressor_stats(LazPerf_VlrCompressorPtr compressor)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return vlr_compressor->stats();
+}
+
+uint32_t lazperf_auto_chunk_size(uint64_t expected_point_count, size_t num_threads)
+{
+	return autoChunkSize(expected_point_count, num_threads);
+}
+
+LazPerf_VoidResult lazperf_vlr_compressor_set_chunk_size(LazPerf_VlrCompressorPtr compressor, uint32_t chunk_size)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->setChunkSize(chunk_size);
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_compressor_set_auto_chunk_size(
+		LazPerf_VlrCompressorPtr compressor,
+		uint64_t expected_point_count,
+		size_t num_threads)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->setChunkSize(autoChunkSize(expected_point_count, num_threads));
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_compressor_enable_variable_chunks(LazPerf_VlrCompressorPtr compressor)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->enableVariableChunks();
+	});
+}
+
+LazPerf_VoidResult lazperf_vlr_compressor_close_chunk(LazPerf_VlrCompressorPtr compressor)
+{
+	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
+	return makeVoidResult([&]()
+	{
+		vlr_compressor->closeChunk();
+	});
+}
+
 uint64_t lazperf_vlr_compressor_write_chunk_table(LazPerf_VlrCompressorPtr compressor)
 {
 	auto vlr_compressor = reinterpret_cast<VlrCompressor *>(compressor);
@@ -570,10 +3178,26 @@ void lazperf_delete_result(struct LazPerf_BufferResult *result)
 {
 	if (result->is_error)
 	{
-		free(result->error.error_msg);
+		lazperfFree(result->error.error_msg);
 	}
 	else
 	{
-		delete result->points_buffer.data;
+		lazperfFree(result->points_buffer.data);
+	}
+}
+
+void lazperf_delete_void_result(struct LazPerf_VoidResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
+	}
+}
+
+void lazperf_delete_size_result(struct LazPerf_SizeResult *result)
+{
+	if (result->is_error)
+	{
+		lazperfFree(result->error.error_msg);
 	}
 }
\ No newline at end of file
@@ -38,13 +38,82 @@ struct LazPerf_BufferResult
 };
 
 
+/**
+ * Result of an operation that does not return a buffer
+ * (e.g. it writes into a buffer provided by the caller).
+ * If the result is an error "is_error" will be set to 1 and
+ * "error" owns memory, use 'lazperf_delete_void_result' to free it.
+ */
+struct LazPerf_VoidResult
+{
+	int is_error;
+	struct LazPerf_Error error;
+};
+
+/**
+ * Result of an operation that returns a size (e.g. the number of bytes written).
+ * If the result is an error "is_error" will be set to 1 and
+ * "error" owns memory, use 'lazperf_delete_size_result' to free it.
+ */
+struct LazPerf_SizeResult
+{
+	int is_error;
+	union
+	{
+		size_t size;
+		struct LazPerf_Error error;
+	};
+};
+
+
 /*
  * Frees the memory owned by either variant of the result union
  */
 void lazperf_delete_result(struct LazPerf_BufferResult *result);
 
+/*
+ * Frees the error message of the result, if any
+ */
+void lazperf_delete_void_result(struct LazPerf_VoidResult *result);
+
+/*
+ * Frees the error message of the result, if any
+ */
+void lazperf_delete_size_result(struct LazPerf_SizeResult *result);
+
 void lazperf_delete_sized_buffer(struct LazPerf_SizedBuffer buffer);
 
+/* Allocator */
+
+typedef void *(*LazPerf_MallocFn)(void *ctx, size_t size);
+
+/**
+ * Must behave like realloc: 'ptr' may be NULL
+ */
+typedef void *(*LazPerf_ReallocFn)(void *ctx, void *ptr, size_t size);
+
+typedef void (*LazPerf_FreeFn)(void *ctx, void *ptr);
+
+/**
+ * Sets the allocator used for the memory owned by the library:
+ * the buffers, arrays and error messages of the results, and the large internal buffers
+ * (compressed data, decompression scratch space, read and write blocks).
+ * The functions may be called concurrently from several threads and are given 'ctx'.
+ *
+ * The small objects (compressors, decompressors, schemas...) and the laz-perf models
+ * still use the default heap.
+ *
+ * Must be called before any other function of the library, or at least while no memory allocated
+ * by the library is still alive, as it is freed with the allocator set at the time it is freed.
+ *
+ * Passing NULL functions restores the default allocator (malloc, realloc and free).
+ */
+void lazperf_set_allocator(
+		LazPerf_MallocFn malloc_fn,
+		LazPerf_ReallocFn realloc_fn,
+		LazPerf_FreeFn free_fn,
+		void *ctx);
+
 /* Record Schema */
 
 
@@ -142,6 +211,16 @@ size_t lazperf_laz_vlr_record_data_size(LazPerf_LazVlrPtr vlr);
  */
 void lazperf_laz_vlr_copy_record_data(LazPerf_LazVlrPtr vlr, char *out);
 
+/**
+ * Sets the number of points per chunk stored in the vlr, to describe points compressed with
+ * a chunk size other than the default (see 'lazperf_compress_points_parallel')
+ *
+ * @param vlr
+ * @param chunk_size number of points per chunk
+ * @return the result, an error if chunk_size is 0 or 0xFFFFFFFF
+ */
+struct LazPerf_VoidResult lazperf_laz_vlr_set_chunk_size(LazPerf_LazVlrPtr vlr, uint32_t chunk_size);
+
 
 
 /* Decompression API */
@@ -183,6 +262,222 @@ void lazperf_decompress_points_into(
 		uint8_t *out_buffer
 );
 
+/**
+ * Decompress the points contained in the buffer into the output buffer,
+ * using several threads.
+ *
+ * The chunk table is read to find where each chunk of points starts, chunks are then
+ * decompressed concurrently, each one directly into its place in the output buffer.
+ *
+ * @param compressed_points_buffer The buffer of points to decompress, it must also contain the chunk table
+ * @param buffer_size size of the buffer
+ * @param chunk_table_offset position of the chunk table in the buffer, that is,
+ * the offset stored in the 8 bytes preceding the points minus (offset_to_point_data + 8)
+ * @param lazsip_vlr_data The record data of the Laszip Vlr
+ * @param num_points number of points stored (and to be decompressed) in the input buffer
+ * @param point_size size of one point in bytes (each points have the same size)
+ * @param out_buffer where the points are written, must be at least num_points * point_size bytes
+ * @param num_threads number of threads to use, 0 to use as many as the hardware supports
+ * @return The result of the decompression
+ */
+struct LazPerf_VoidResult lazperf_decompress_points_parallel(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *lazsip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		uint8_t *out_buffer,
+		size_t num_threads
+);
+
+/**
+ * A buffer of compressed points to decompress as part of a batch,
+ * the fields have the same meaning as the parameters of 'lazperf_decompress_points_parallel'
+ */
+struct LazPerf_DecompressJob
+{
+	const uint8_t *compressed_points_buffer;
+	size_t buffer_size;
+	uint64_t chunk_table_offset;
+	const char *laszip_vlr_data;
+	size_t num_points;
+	size_t point_size;
+	uint8_t *out_buffer;
+};
+
+/**
+ * Decompresses many buffers of points (e.g. the tiles of a dataset) on one pool of threads.
+ *
+ * The jobs are split into their chunks, and the chunks of all jobs are shared by the threads,
+ * the largest ones being started first. So the threads stay busy even when a few jobs are
+ * much larger than the others, which is not the case when each job runs on its own thread.
+ *
+ * A job that fails does not stop the others.
+ *
+ * @param jobs the buffers to decompress
+ * @param num_jobs number of jobs
+ * @param num_threads number of threads to use, 0 to use as many as the hardware supports
+ * @param job_results if not NULL, array of 'num_jobs' results where the result of each job is written,
+ * each one has to be freed with 'lazperf_delete_void_result'
+ * @return an error if any of the jobs failed, which gives the number of failed jobs and the first error
+ */
+struct LazPerf_VoidResult lazperf_decompress_batch(
+		const struct LazPerf_DecompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		struct LazPerf_VoidResult *job_results
+);
+
+/* Chunk Table */
+
+/**
+ * Position and size of a chunk of compressed points.
+ */
+struct LazPerf_ChunkInfo
+{
+	/* offset of the chunk, relative to the start of the compressed points
+	 * (that is, just after the 8 bytes offset to the chunk table) */
+	uint64_t offset;
+	/* size in bytes of the compressed chunk */
+	uint64_t compressed_size;
+	/* number of points in the chunk */
+	uint64_t point_count;
+	/* index of the first point of the chunk */
+	uint64_t first_point;
+};
+
+/**
+ * The chunk table of compressed points.
+ * Memory is owned, use 'lazperf_delete_chunk_table' to free it.
+ */
+struct LazPerf_ChunkTable
+{
+	struct LazPerf_ChunkInfo *chunks;
+	size_t num_chunks;
+};
+
+/**
+ * Result of reading a chunk table.
+ * If the result is an error "is_error" will be set to 1.
+ *
+ * Both elements of the union own memory,
+ * use 'lazperf_delete_chunk_table_result' to free it.
+ */
+struct LazPerf_ChunkTableResult
+{
+	int is_error;
+	union
+	{
+		struct LazPerf_ChunkTable chunk_table;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Returns the position of the chunk table relative to the start of the compressed points.
+ *
+ * @param point_data the point data as stored in the LAZ file, starting with the 8 bytes offset to the chunk table
+ * @param offset_to_point_data offset in bytes to the start of point records in the LAZ file
+ * @return the position to use with 'lazperf_read_chunk_table' & co,
+ * or UINT64_MAX if the file has no chunk table
+ */
+uint64_t lazperf_read_chunk_table_offset(const uint8_t *point_data, size_t offset_to_point_data);
+
+/**
+ * Reads the chunk table that follows the compressed points.
+ *
+ * @param compressed_points_buffer the compressed points (without the 8 bytes offset to the chunk table)
+ * the buffer must also contain the chunk table
+ * @param buffer_size size of the buffer
+ * @param chunk_table_offset position of the chunk table in the buffer (see 'lazperf_read_chunk_table_offset')
+ * @param laszip_vlr_data record data of the laszip vlr
+ * @param num_points total number of compressed points
+ * @return The chunk table
+ */
+struct LazPerf_ChunkTableResult lazperf_read_chunk_table(
+		const uint8_t *compressed_points_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *laszip_vlr_data,
+		size_t num_points
+);
+
+/**
+ * Frees the memory owned by the chunk table
+ */
+void lazperf_delete_chunk_table(struct LazPerf_ChunkTable chunk_table);
+
+/**
+ * Frees the memory owned by either variant of the result union
+ */
+void lazperf_delete_chunk_table_result(struct LazPerf_ChunkTableResult *result);
+
+/* Merging */
+
+/**
+ * A buffer of compressed points to merge with others,
+ * the fields have the same meaning as the parameters of 'lazperf_decompress_points_parallel'
+ */
+struct LazPerf_MergeInput
+{
+	const uint8_t *compressed_points_buffer;
+	size_t buffer_size;
+	uint64_t chunk_table_offset;
+	const char *laszip_vlr_data;
+	size_t num_points;
+};
+
+struct LazPerf_MergedPoints
+{
+	/* the compressed points, with the offset to the chunk table and the chunk table
+	 * (as returned by 'lazperf_compress_points') */
+	struct LazPerf_SizedBuffer points_buffer;
+	/* record data of the laszip vlr to store with the merged points */
+	struct LazPerf_SizedBuffer laszip_vlr_data;
+};
+
+/**
+ * If the result is an error "is_error" will be set to 1.
+ * Both variants of the union own memory, use 'lazperf_delete_merge_result' to free it.
+ */
+struct LazPerf_MergeResult
+{
+	int is_error;
+	union
+	{
+		struct LazPerf_MergedPoints merged;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Merges buffers of compressed points into one, without decompressing them.
+ *
+ * As chunks are compressed independently, the chunks of the inputs are copied as they are,
+ * one input after the other, and a chunk table listing all of them is written.
+ *
+ * The inputs must have the same laszip vlr, except for the chunk size.
+ * The merged points keep the chunk size of the inputs when they all have the same one
+ * and only the last chunk of the last input is not full, otherwise they use variable size chunks,
+ * which is why the laszip vlr of the merged points is returned.
+ *
+ * @param inputs the buffers to merge, in the order their points are to be stored
+ * @param num_inputs number of inputs
+ * @param offset_to_point_data offset in bytes to the start of point records in the file the merged
+ * points are written to (see 'lazperf_compress_points')
+ * @return the merged points and their laszip vlr
+ */
+struct LazPerf_MergeResult lazperf_merge_points(
+		const struct LazPerf_MergeInput *inputs,
+		size_t num_inputs,
+		size_t offset_to_point_data
+);
+
+void lazperf_delete_merge_result(struct LazPerf_MergeResult *result);
+
+
+
 /**
  * Structure able to decompress points taken from a LAZ file
  *
@@ -190,6 +485,26 @@ void lazperf_decompress_points_into(
  */
 typedef void *LazPerf_VlrDecompressorPtr;
 
+/**
+ * Result of creating a VlrDecompressor
+ * If the result is an error "is_error" will be set to 1,
+ * and "error" owns memory, use 'lazperf_delete_vlr_decompressor_result' to free it.
+ */
+struct LazPerf_VlrDecompressorResult
+{
+	int is_error;
+	union
+	{
+		LazPerf_VlrDecompressorPtr decompressor;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Frees the error message of the result, if any (the decompressor is deleted with 'lazperf_delete_vlr_decompressor')
+ */
+void lazperf_delete_vlr_decompressor_result(struct LazPerf_VlrDecompressorResult *result);
+
 /**
  * Creates a VlrDecompressor
  *
@@ -206,6 +521,55 @@ LazPerf_VlrDecompressorPtr lazperf_new_vlr_decompressor(
 		const char *laszip_vlr_data
 );
 
+/**
+ * Callback reading at most 'size' bytes of compressed data into 'buffer'.
+ *
+ * @return the number of bytes read, 0 when there is no more data, (size_t) -1 on error
+ */
+typedef size_t (*LazPerf_ReadCallback)(void *user_data, uint8_t *buffer, size_t size);
+
+/**
+ * Creates a VlrDecompressor that pulls the compressed points from a read callback,
+ * instead of needing them all in memory.
+ *
+ * The decompressor holds at most 2 buffers of 'buffer_size' bytes:
+ * while one is being decompressed, the next one is read by 'read_callback' on a background thread.
+ * 'read_callback' is never called concurrently.
+ *
+ * Such a decompressor cannot read the chunk table and seek.
+ *
+ * @param read_callback called to get the compressed points (without the 8 bytes offset to the chunk table)
+ * @param user_data given to the callback
+ * @param buffer_size size of the blocks requested to 'read_callback'
+ * @param point_size size of one uncompressed point in bytes
+ * @param laszip_vlr_data record data of the laszip vlr found in the LAZ file
+ * @return the new instance
+ */
+LazPerf_VlrDecompressorPtr lazperf_new_vlr_decompressor_from_source(
+		LazPerf_ReadCallback read_callback,
+		void *user_data,
+		size_t buffer_size,
+		size_t point_size,
+		const char *laszip_vlr_data
+);
+
+/**
+ * Makes the decompressor start over on another buffer of compressed points,
+ * which is cheaper than creating a new decompressor when decompressing many small buffers.
+ *
+ * The points must have been compressed with the same laszip vlr (same items and chunk size).
+ * The chunk table and the chunk bounds previously given to the decompressor are forgotten.
+ *
+ * @param decompressor the decompressor instance, it must not read from a source
+ * @param compressed_buffer buffer containing compressed points
+ * @param buffer_size size of the buffer
+ * @return the result, an error if the decompressor reads from a source
+ */
+struct LazPerf_VoidResult lazperf_vlr_decompressor_reset(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const uint8_t *compressed_buffer,
+		size_t buffer_size);
+
 /**
  * Deletes the VlrDecompressor
  */
@@ -220,85 +584,906 @@ void lazperf_delete_vlr_decompressor(LazPerf_VlrDecompressorPtr decompressor);
  */
 void lazperf_vlr_decompressor_decompress_one_to(LazPerf_VlrDecompressorPtr decompressor, char *out);
 
-
-/* Compression API */
+/**
+ * Decompress the next 'num_points' points in the buffer
+ *
+ * This has the same effect as calling 'lazperf_vlr_decompressor_decompress_one_to' 'num_points' times,
+ * but with a lot less overhead per point.
+ *
+ * @param decompressor the decompressor instance
+ * @param num_points number of points to decompress
+ * @param out where the decompressed points will be written, must be at least num_points * point_size bytes
+ * @return the result, an error if the points could not be decompressed
+ */
+struct LazPerf_VoidResult lazperf_vlr_decompressor_decompress_many(
+		LazPerf_VlrDecompressorPtr decompressor,
+		size_t num_points,
+		char *out
+);
 
 /**
- * Compress the points of the 'points' buffer. Intended to be used by LAS/LAZ writers
+ * Reads the chunk table of the compressed points, this is required to be able to seek.
  *
- * @param schema: record schema of the points contained in the buffer
- * @param offset_to_point_data: offset in bytes to the start of point records(see LAS specification)
- * this is required because the first 8 bytes of the compressed points is an offset to the chunk table
- * that is written after the points are compressed, the chunk table offest is relative to the start of the LAZ
- * file
- * @param points: buffer of points to compress
- * @param num_points: number of points in the buffer
- * @return buffer of compressed points, with the offset to chunk table and the chunk table included,
- * so the returned buffre can directly be dumbed into a LAZ file (after headers & vlrs are written of course)
+ * @param decompressor the decompressor instance
+ * @param chunk_table_offset position of the chunk table in the decompressor's buffer
+ * (see 'lazperf_read_chunk_table_offset'), the buffer must contain the chunk table
+ * @param num_points total number of compressed points
+ * @return the result, an error if the chunk table could not be read
  */
-struct LazPerf_BufferResult lazperf_compress_points(
-		LazPerf_RecordSchemaPtr schema,
-		size_t offset_to_point_data,
-		const char *points,
+struct LazPerf_VoidResult lazperf_vlr_decompressor_read_chunk_table(
+		LazPerf_VlrDecompressorPtr decompressor,
+		uint64_t chunk_table_offset,
 		size_t num_points
 );
 
-
 /**
- * Structure used to compress points to write them in a LAZ file.
- *
- * Use this to achieve a semi-streaming compression.
- * However correctly using this is a bit involved.
+ * Moves the decompressor so that the next decompressed point is the one at 'point_index'.
  *
- * Important:
- *    This compressor maintains an internal buffer, where compressed points will be written.
- *    The laszip encoder used by the compressor is 'buffered', meaning that when a point is compressed,
- *    it is not directly written to the internal buffer.
+ * Only the points preceding 'point_index' in its chunk are decompressed
+ * (none of them if the decompressor is already positioned before it in that chunk).
+ * 'lazperf_vlr_decompressor_read_chunk_table' must have been called first.
  *
- *    most of the functions returns the internal buffer size, so you know when compressed
- *    data was written to it, to achieve semi-streaming and save memory, you'll have
- *    to 'extract' (copy then reset size) the data of the internal buffer
+ * @param decompressor the decompressor instance
+ * @param point_index index of the point to move to
+ * @return the result, an error if the index is out of range or the chunk table was not read
+ */
+struct LazPerf_VoidResult lazperf_vlr_decompressor_seek(LazPerf_VlrDecompressorPtr decompressor, size_t point_index);
+
+/**
+ * Destination arrays of a columnar decompression, one value per point in each of them.
+ * Any pointer can be NULL, that field is then not unpacked.
+ */
+struct LazPerf_Columns
+{
+	/* scaled and offset coordinates */
+	double *x;
+	double *y;
+	double *z;
+	uint16_t *intensity;
+	uint8_t *return_number;
+	uint8_t *number_of_returns;
+	/* without the synthetic, key-point and withheld flags */
+	uint8_t *classification;
+	uint16_t *point_source_id;
+	/* the schema must have the gpstime item */
+	double *gps_time;
+	/* the schema must have the rgb item */
+	uint16_t *red;
+	uint16_t *green;
+	uint16_t *blue;
+};
+
+/**
+ * Decompresses the next 'num_points' points directly into per field arrays.
  *
- * How to use:
- *  1) Create an instance of the VlrCompressor
- *  2) call compress while you have points to compress
- *     on each call if compress returns 0 continue else extract the compressed data
- *     wherever you like
- *   3) call done when you are done compressing points
- *   4) extract data
- *   5) write chunk_table
- *   6) extract data
- *   7) delete compressor
+ * The points are decompressed in small blocks that stay in cache and unpacked from there,
+ * X, Y and Z are converted to doubles (value * scale + offset) with vector instructions.
+ * Only the pointwise items (point formats 0 to 5) are supported.
  *
- *   You will also have to update the first 8 bytes of the compressed data, as it is the offset the chunk table
+ * @param decompressor the decompressor instance
+ * @param num_points number of points to decompress
+ * @param scales the X, Y, Z scales, as in the LAS header
+ * @param offsets the X, Y, Z offsets, as in the LAS header
+ * @param columns the destination arrays, each of them must have room for 'num_points' values
+ * @return the result, an error if a requested field is not in the schema
  */
-typedef void *LazPerf_VlrCompressorPtr;
+struct LazPerf_VoidResult lazperf_vlr_decompressor_decompress_columns(
+		LazPerf_VlrDecompressorPtr decompressor,
+		size_t num_points,
+		const double scales[3],
+		const double offsets[3],
+		const struct LazPerf_Columns *columns);
 
 /**
- * Creates a new VlrCompressor
- *
- * @param schema : schema of the points to be compressed
- * @return the new instance
+ * Axis aligned box, in the int32 coordinates stored in the point records
+ * (that is, before the scale and offset of the LAS header are applied).
  */
-LazPerf_VlrCompressorPtr lazperf_new_vlr_compressor(LazPerf_RecordSchemaPtr schema);
+struct LazPerf_Bounds
+{
+	int32_t mins[3];
+	int32_t maxs[3];
+};
 
 /**
- * Delete the compressor instance
+ * Returns the number of chunks of the compressed points,
+ * 0 if the chunk table was not read.
+ */
+size_t lazperf_vlr_decompressor_num_chunks(LazPerf_VlrDecompressorPtr decompressor);
+
+/**
+ * Decompresses all the points once to compute the bounds of each chunk,
+ * the bounds are kept by the decompressor for the next queries.
+ * 'lazperf_vlr_decompressor_read_chunk_table' must have been called first.
  *
- * @param compressor the instance to delete
+ * @param decompressor the decompressor instance
+ * @param bounds where the bounds of each chunk are copied, 'lazperf_vlr_decompressor_num_chunks' entries,
+ * can be NULL
  */
-void lazperf_delete_vlr_compressor(LazPerf_VlrCompressorPtr compressor);
+struct LazPerf_VoidResult lazperf_vlr_decompressor_compute_chunk_bounds(
+		LazPerf_VlrDecompressorPtr decompressor,
+		struct LazPerf_Bounds *bounds);
 
 /**
- * Compress one point
+ * Gives the decompressor the bounds of each chunk, computed previously
+ * (by 'lazperf_vlr_decompressor_compute_chunk_bounds' or stored in an index),
+ * so that queries do not have to compute them.
  *
- * @param compressor the compressor instance
- * @param inbuf point to compress, if the 'inbuf''s size is less than the point size specified by the
- * record schema used when creating the instance, you'll get UB
- * @return the size of the internal buffer after the point was compressed
+ * @param decompressor the decompressor instance
+ * @param bounds bounds of each chunk, copied
+ * @param num_chunks number of entries in 'bounds', must be the number of chunks
+ */
+struct LazPerf_VoidResult lazperf_vlr_decompressor_set_chunk_bounds(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const struct LazPerf_Bounds *bounds,
+		size_t num_chunks);
+
+/**
+ * Returns the points inside 'box' (bounds included), in file order.
+ *
+ * Only the chunks whose bounds intersect the box are decompressed, the points of the chunks
+ * entirely inside the box are not tested. The chunk bounds are computed on the first query
+ * if they were not computed or set before.
+ * The position of the decompressor after the query is unspecified, use 'lazperf_vlr_decompressor_seek'
+ * to continue decompressing from a known point.
+ *
+ * @param decompressor the decompressor instance
+ * @param box the box, in the int32 coordinates of the point records
+ * @return the matching points, packed
+ */
+struct LazPerf_BufferResult lazperf_vlr_decompressor_query_box(
+		LazPerf_VlrDecompressorPtr decompressor,
+		const struct LazPerf_Bounds *box);
+
+/**
+ * Bounds and gps time range of each chunk, built while compressing
+ * (see 'lazperf_vlr_compressor_enable_chunk_index').
+ *
+ * 'bounds' can be given as is to 'lazperf_vlr_decompressor_set_chunk_bounds'.
+ * The gps times are 0 when the points have none.
+ */
+struct LazPerf_ChunkIndex
+{
+	size_t num_chunks;
+	struct LazPerf_Bounds *bounds;
+	double *min_gps_times;
+	double *max_gps_times;
+};
+
+/**
+ * Result of parsing a chunk index
+ * If the result is an error "is_error" will be set to 1,
+ * use 'lazperf_delete_chunk_index_result' to free the memory in both cases.
+ */
+struct LazPerf_ChunkIndexResult
+{
+	int is_error;
+	union
+	{
+		struct LazPerf_ChunkIndex chunk_index;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Parses the chunk index data returned by 'lazperf_vlr_compressor_chunk_index_data'
+ * (stored in a sidecar file or in a VLR, as the caller sees fit)
+ */
+struct LazPerf_ChunkIndexResult lazperf_parse_chunk_index(const uint8_t *data, size_t size);
+
+/**
+ * Frees the memory owned by the chunk index
+ */
+void lazperf_delete_chunk_index(struct LazPerf_ChunkIndex chunk_index);
+
+/**
+ * Frees the memory owned by the result (the chunk index or the error message)
+ */
+void lazperf_delete_chunk_index_result(struct LazPerf_ChunkIndexResult *result);
+
+
+/* Prefetching decompression */
+
+/**
+ * Decompresses the chunks of points on worker threads, ahead of the thread consuming the points,
+ * so that the decompression overlaps with the processing of the points.
+ *
+ * The chunks are decompressed into a fixed ring of 'num_buffers' buffers (each as large as the largest chunk),
+ * a worker moves on to the next chunk only once a buffer is free, so the memory used stays fixed.
+ */
+typedef void *LazPerf_PrefetchingDecompressorPtr;
+
+/**
+ * Result of creating a prefetching decompressor
+ * If the result is an error "is_error" will be set to 1,
+ * and "error" owns memory, use 'lazperf_delete_prefetching_decompressor_result' to free it.
+ */
+struct LazPerf_PrefetchingDecompressorResult
+{
+	int is_error;
+	union
+	{
+		LazPerf_PrefetchingDecompressorPtr decompressor;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Creates a prefetching decompressor, its workers start decompressing right away.
+ *
+ * @param compressed_buffer buffer containing compressed points, it must also contain the chunk table
+ * and outlive the decompressor
+ * @param buffer_size size of the buffer
+ * @param chunk_table_offset position of the chunk table in the buffer (see 'lazperf_decompress_points_parallel')
+ * @param laszip_vlr_data record data of the laszip vlr
+ * @param num_points number of points in the buffer
+ * @param point_size size of one point in bytes
+ * @param num_threads number of worker threads, 0 for one less than the hardware supports
+ * (the consuming thread being busy with the points)
+ * @param num_buffers number of chunk buffers, 0 for twice the number of workers
+ * @return the decompressor, to be deleted with 'lazperf_delete_prefetching_decompressor'
+ */
+struct LazPerf_PrefetchingDecompressorResult lazperf_new_prefetching_decompressor(
+		const uint8_t *compressed_buffer,
+		size_t buffer_size,
+		uint64_t chunk_table_offset,
+		const char *laszip_vlr_data,
+		size_t num_points,
+		size_t point_size,
+		size_t num_threads,
+		size_t num_buffers
+);
+
+/**
+ * Frees the error message of the result, if any
+ */
+void lazperf_delete_prefetching_decompressor_result(struct LazPerf_PrefetchingDecompressorResult *result);
+
+/**
+ * Waits for the next chunk of points, in order, and releases the previous one.
+ *
+ * @param decompressor the decompressor instance
+ * @param points set to the points of the chunk, they stay valid until the next call
+ * @return the number of points of the chunk, 0 once all the chunks were returned,
+ * an error if the chunk could not be decompressed
+ */
+struct LazPerf_SizeResult lazperf_prefetching_decompressor_next_chunk(
+		LazPerf_PrefetchingDecompressorPtr decompressor,
+		const char **points);
+
+/**
+ * Stops the workers and deletes the decompressor
+ */
+void lazperf_delete_prefetching_decompressor(LazPerf_PrefetchingDecompressorPtr decompressor);
+
+
+/* Statistics */
+
+#define LAZPERF_STATS_MAX_ITEMS 8
+
+/**
+ * What compressing or decompressing one chunk cost
+ */
+struct LazPerf_ChunkStats
+{
+	uint64_t first_point;
+	/* Number of points compressed / decompressed so far in the chunk */
+	uint64_t point_count;
+	uint64_t compressed_bytes;
+	/* Wall time spent in the library on the points of the chunk, the times below included, not the item bytes */
+	double seconds;
+	/* Time spent building the models at the start of the chunk */
+	double model_reset_seconds;
+	/*
+	 * Compressor: time spent in the write and patch callbacks of the sink.
+	 * Decompressor: time spent waiting for the read callback of the source.
+	 */
+	double io_seconds;
+	/*
+	 * Estimated compressed bytes of each record item, in the order of the schema (when measured).
+	 * When the schema has more items than LAZPERF_STATS_MAX_ITEMS, the last entry counts the remaining items.
+	 * Only set once the chunk is complete.
+	 */
+	uint64_t item_bytes[LAZPERF_STATS_MAX_ITEMS];
+};
+
+/**
+ * Statistics of the chunks processed so far, the last one may still be in progress.
+ * 'chunks' is owned by the compressor / decompressor, and is valid until its next call.
+ */
+struct LazPerf_Stats
+{
+	size_t num_chunks;
+	const struct LazPerf_ChunkStats *chunks;
+	/* Number of entries set in the 'item_bytes' of the chunks, 0 when the item bytes are not measured */
+	size_t num_items;
+};
+
+/**
+ * Makes the decompressor record statistics about each chunk, must be called before any point is decompressed.
+ * When the statistics are not enabled, they cost nothing.
+ *
+ * @param decompressor the decompressor instance
+ * @param measure_item_bytes whether to estimate the compressed bytes of each record item,
+ * which is expensive: the decompressed points are compressed again, once per item
+ * @return the result, an error if points were already decompressed
+ */
+struct LazPerf_VoidResult lazperf_vlr_decompressor_enable_stats(
+		LazPerf_VlrDecompressorPtr decompressor,
+		int measure_item_bytes);
+
+/**
+ * Returns the statistics recorded so far, no chunks if they are not enabled.
+ * The item bytes of the chunk being decompressed are those of its points decompressed so far.
+ */
+struct LazPerf_Stats lazperf_vlr_decompressor_stats(LazPerf_VlrDecompressorPtr decompressor);
+
+
+/* LAZ file reader */
+
+/**
+ * The fields of the public header block of a LAS/LAZ file
+ */
+struct LazPerf_LasHeader
+{
+	uint16_t file_source_id;
+	uint16_t global_encoding;
+	uint8_t version_major;
+	uint8_t version_minor;
+	char system_identifier[32];
+	char generating_software[32];
+	uint16_t creation_day;
+	uint16_t creation_year;
+	uint16_t header_size;
+	uint32_t offset_to_point_data;
+	uint32_t number_of_vlrs;
+	/* point format id, without the bits LASzip sets to mark compressed points */
+	uint8_t point_format;
+	uint16_t point_size;
+	uint64_t point_count;
+	/* only the first 5 are used by LAS < 1.4 */
+	uint64_t points_by_return[15];
+	double scales[3];
+	double offsets[3];
+	double mins[3];
+	double maxs[3];
+	/* 0 for LAS < 1.4 */
+	uint64_t start_of_first_evlr;
+};
+
+/**
+ * Hints on how the compressed points of a file are going to be accessed
+ */
+enum LazPerf_AccessPattern
+{
+	LAZPERF_ACCESS_NORMAL = 0,
+	/* points are read from start to end, the OS should read ahead aggressively */
+	LAZPERF_ACCESS_SEQUENTIAL = 1,
+	/* points are read at random positions (seek), the OS should not read ahead */
+	LAZPERF_ACCESS_RANDOM = 2,
+	/* the whole points are going to be read soon, the OS should start reading them */
+	LAZPERF_ACCESS_WILLNEED = 3
+};
+
+/**
+ * A LAZ file, memory mapped.
+ *
+ * The header and the laszip vlr are parsed when the file is opened,
+ * the compressed points are never copied: decompressors read them straight from the mapping.
+ */
+typedef void *LazPerf_FileReaderPtr;
+
+/**
+ * Result of opening a file
+ * If the result is an error "is_error" will be set to 1,
+ * and "error" owns memory, use 'lazperf_delete_file_reader_result' to free it.
+ */
+struct LazPerf_FileReaderResult
+{
+	int is_error;
+	union
+	{
+		LazPerf_FileReaderPtr reader;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Opens and maps a LAZ file
+ *
+ * @param path path to the file
+ * @return the reader, use 'lazperf_close_file' once done with it
+ */
+struct LazPerf_FileReaderResult lazperf_open_file(const char *path);
+
+/**
+ * Frees the error message of the result, if any
+ * (the reader itself is not closed)
+ */
+void lazperf_delete_file_reader_result(struct LazPerf_FileReaderResult *result);
+
+/**
+ * Unmaps and closes the file.
+ * Decompressors created from the reader must not be used after that.
+ */
+void lazperf_close_file(LazPerf_FileReaderPtr reader);
+
+/**
+ * Returns the public header block of the file
+ */
+const struct LazPerf_LasHeader *lazperf_file_reader_header(LazPerf_FileReaderPtr reader);
+
+/**
+ * Returns the number of points in the file
+ */
+size_t lazperf_file_reader_point_count(LazPerf_FileReaderPtr reader);
+
+/**
+ * Returns the size in bytes of one uncompressed point
+ */
+size_t lazperf_file_reader_point_size(LazPerf_FileReaderPtr reader);
+
+/**
+ * Returns the record data of the laszip vlr, owned by the reader
+ */
+const char *lazperf_file_reader_laszip_vlr_data(LazPerf_FileReaderPtr reader);
+
+/**
+ * Returns the compressed points (without the 8 bytes offset to the chunk table), owned by the reader
+ *
+ * @param reader the reader
+ * @param size set to the size of the compressed points, chunk table included
+ */
+const uint8_t *lazperf_file_reader_compressed_points(LazPerf_FileReaderPtr reader, size_t *size);
+
+/**
+ * Returns the position of the chunk table relative to the compressed points,
+ * UINT64_MAX if the file has no chunk table
+ */
+uint64_t lazperf_file_reader_chunk_table_offset(LazPerf_FileReaderPtr reader);
+
+/**
+ * Gives the OS a hint on how the compressed points are going to be accessed
+ */
+void lazperf_file_reader_advise(LazPerf_FileReaderPtr reader, enum LazPerf_AccessPattern access_pattern);
+
+/**
+ * Creates a decompressor reading the points from the mapped file.
+ * The chunk table, if the file has one, is already read, so the decompressor can seek.
+ *
+ * The decompressor must be deleted with 'lazperf_delete_vlr_decompressor'
+ * and must not outlive the reader.
+ *
+ * @return the decompressor, or an error if the laszip vlr or the chunk table of the file are invalid
+ */
+struct LazPerf_VlrDecompressorResult lazperf_file_reader_new_decompressor(LazPerf_FileReaderPtr reader);
+
+/**
+ * Creates a prefetching decompressor reading the points from the mapped file,
+ * which must have a chunk table (see 'lazperf_new_prefetching_decompressor').
+ * The decompressor must not outlive the reader.
+ */
+struct LazPerf_PrefetchingDecompressorResult lazperf_file_reader_new_prefetching_decompressor(
+		LazPerf_FileReaderPtr reader,
+		size_t num_threads,
+		size_t num_buffers);
+
+
+/* LAZ file writer */
+
+/**
+ * A LAZ file being written.
+ *
+ * The header, the VLRs, the compressed points and the chunk table are streamed to the file
+ * in one pass, the header and the offset to the chunk table are patched in place once all
+ * the points are written.
+ */
+typedef void *LazPerf_FileWriterPtr;
+
+/**
+ * Result of creating a file
+ * If the result is an error "is_error" will be set to 1,
+ * and "error" owns memory, use 'lazperf_delete_file_writer_result' to free it.
+ */
+struct LazPerf_FileWriterResult
+{
+	int is_error;
+	union
+	{
+		LazPerf_FileWriterPtr writer;
+		struct LazPerf_Error error;
+	};
+};
+
+/**
+ * Creates (or truncates) a LAZ file
+ *
+ * Only the version, file_source_id, global_encoding, system_identifier, generating_software,
+ * creation date, point_format, scales and offsets of 'header' are used,
+ * the other fields are computed by the writer.
+ *
+ * @param path path to the file
+ * @param schema record schema of the points that will be written
+ * @param header header of the file
+ * @return the writer, use 'lazperf_delete_file_writer' once done with it
+ */
+struct LazPerf_FileWriterResult lazperf_create_file(
+		const char *path,
+		LazPerf_RecordSchemaPtr schema,
+		const struct LazPerf_LasHeader *header);
+
+/**
+ * Frees the error message of the result, if any
+ * (the writer itself is not deleted)
+ */
+void lazperf_delete_file_writer_result(struct LazPerf_FileWriterResult *result);
+
+/**
+ * Adds a VLR to the file, must be called before any point is written.
+ *
+ * @param writer the writer
+ * @param user_id user id of the VLR, at most 16 chars
+ * @param record_id record id of the VLR
+ * @param description description of the VLR, at most 32 chars, can be NULL
+ * @param data record data of the VLR
+ * @param size size of data, at most 65535
+ */
+struct LazPerf_VoidResult lazperf_file_writer_add_vlr(
+		LazPerf_FileWriterPtr writer,
+		const char *user_id,
+		uint16_t record_id,
+		const char *description,
+		const uint8_t *data,
+		size_t size);
+
+/**
+ * Sets the number of points per chunk (see 'lazperf_vlr_compressor_set_chunk_size'
+ * and 'lazperf_auto_chunk_size'), must be called before any point is written.
+ */
+struct LazPerf_VoidResult lazperf_file_writer_set_chunk_size(LazPerf_FileWriterPtr writer, uint32_t chunk_size);
+
+/**
+ * Compresses and writes points to the file.
+ * The bounds and the number of points by return of the header are updated as points are written.
+ *
+ * @param writer the writer
+ * @param points the points, 'num_points' * point size bytes
+ * @param num_points number of points
+ */
+struct LazPerf_VoidResult lazperf_file_writer_write_points(
+		LazPerf_FileWriterPtr writer,
+		const char *points,
+		size_t num_points);
+
+/**
+ * Writes the chunk table, patches the header and closes the file.
+ * No points can be written after that.
+ */
+struct LazPerf_VoidResult lazperf_file_writer_finish(LazPerf_FileWriterPtr writer);
+
+/**
+ * Deletes the writer, the file is closed but not finished if 'lazperf_file_writer_finish' was not called
+ */
+void lazperf_delete_file_writer(LazPerf_FileWriterPtr writer);
+
+
+/* Compression API */
+
+/**
+ * Compress the points of the 'points' buffer. Intended to be used by LAS/LAZ writers
+ *
+ * @param schema: record schema of the points contained in the buffer
+ * @param offset_to_point_data: offset in bytes to the start of point records(see LAS specification)
+ * this is required because the first 8 bytes of the compressed points is an offset to the chunk table
+ * that is written after the points are compressed, the chunk table offest is relative to the start of the LAZ
+ * file
+ * @param points: buffer of points to compress
+ * @param num_points: number of points in the buffer
+ * @return buffer of compressed points, with the offset to chunk table and the chunk table included,
+ * so the returned buffre can directly be dumbed into a LAZ file (after headers & vlrs are written of course)
+ */
+struct LazPerf_BufferResult lazperf_compress_points(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points
+);
+
+/**
+ * Returns an upper bound of the number of bytes 'lazperf_compress_points_into'
+ * will write when compressing 'num_points' points of the given schema.
+ *
+ * @param schema: record schema of the points to compress
+ * @param num_points: number of points to compress
+ * @param chunk_size: number of points per chunk, as given to 'lazperf_compress_points_into'
+ * @return the size in bytes
+ */
+size_t lazperf_compress_bound(LazPerf_RecordSchemaPtr schema, size_t num_points, uint32_t chunk_size);
+
+/**
+ * Same as 'lazperf_compress_points' but the compressed points are written directly into 'out'
+ * instead of a newly allocated buffer.
+ *
+ * @param schema: record schema of the points contained in the buffer
+ * @param offset_to_point_data: offset in bytes to the start of point records (see 'lazperf_compress_points')
+ * @param points: buffer of points to compress
+ * @param num_points: number of points in the buffer
+ * @param chunk_size: number of points per chunk, 0 for the default of the laszip vlr
+ * @param out: where the compressed points, the offset to the chunk table and the chunk table are written
+ * @param out_capacity: size of 'out', 'lazperf_compress_bound' gives a capacity that is always enough
+ * @return the number of bytes written to 'out', an error if 'out' was too small
+ */
+struct LazPerf_SizeResult lazperf_compress_points_into(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t chunk_size,
+		uint8_t *out,
+		size_t out_capacity
+);
+
+/**
+ * Same as 'lazperf_compress_points' but compresses the chunks of points concurrently,
+ * each chunk with its own encoder.
+ *
+ * With the default chunk size, the output is byte-identical to the one of 'lazperf_compress_points'.
+ * Otherwise the laszip vlr written along the points must have the same chunk size
+ * (see 'lazperf_laz_vlr_set_chunk_size').
+ *
+ * @param schema: record schema of the points contained in the buffer
+ * @param offset_to_point_data: offset in bytes to the start of point records (see 'lazperf_compress_points')
+ * @param points: buffer of points to compress
+ * @param num_points: number of points in the buffer
+ * @param chunk_size: number of points per chunk, 0 for the default of the laszip vlr (50 000),
+ * the chunks are what the threads share, so a buffer needs several of them to be compressed concurrently
+ * @param num_threads: number of threads to use, 0 to use as many as the hardware supports
+ * @return buffer of compressed points, with the offset to chunk table and the chunk table included
+ */
+struct LazPerf_BufferResult lazperf_compress_points_parallel(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		const char *points,
+		size_t num_points,
+		uint32_t chunk_size,
+		size_t num_threads
+);
+
+/**
+ * Points to compress as part of a batch,
+ * the fields have the same meaning as the parameters of 'lazperf_compress_points_parallel'
+ */
+struct LazPerf_CompressJob
+{
+	LazPerf_RecordSchemaPtr schema;
+	size_t offset_to_point_data;
+	const char *points;
+	size_t num_points;
+	/* number of points per chunk, 0 for the default of the laszip vlr */
+	uint32_t chunk_size;
+};
+
+/**
+ * Compresses many buffers of points on one pool of threads, see 'lazperf_decompress_batch'.
+ *
+ * The output of each job is byte-identical to the one of 'lazperf_compress_points_parallel'
+ * (and so to the one of 'lazperf_compress_points' with the default chunk size).
+ *
+ * @param jobs the points to compress
+ * @param num_jobs number of jobs
+ * @param num_threads number of threads to use, 0 to use as many as the hardware supports
+ * @param job_results array of 'num_jobs' results where the compressed points of each job are written,
+ * each one has to be freed with 'lazperf_delete_result'
+ * @return an error if any of the jobs failed, which gives the number of failed jobs and the first error
+ */
+struct LazPerf_VoidResult lazperf_compress_batch(
+		const struct LazPerf_CompressJob *jobs,
+		size_t num_jobs,
+		size_t num_threads,
+		struct LazPerf_BufferResult *job_results
+);
+
+/**
+ * Structure used to compress points to write them in a LAZ file.
+ *
+ * Use this to achieve a semi-streaming compression.
+ * However correctly using this is a bit involved.
+ *
+ * Important:
+ *    This compressor maintains an internal buffer, where compressed points will be written.
+ *    The laszip encoder used by the compressor is 'buffered', meaning that when a point is compressed,
+ *    it is not directly written to the internal buffer.
+ *
+ *    most of the functions returns the internal buffer size, so you know when compressed
+ *    data was written to it, to achieve semi-streaming and save memory, you'll have
+ *    to 'extract' (copy then reset size) the data of the internal buffer
+ *
+ * How to use:
+ *  1) Create an instance of the VlrCompressor
+ *  2) call compress while you have points to compress
+ *     on each call if compress returns 0 continue else extract the compressed data
+ *     wherever you like
+ *   3) call done when you are done compressing points
+ *   4) extract data
+ *   5) write chunk_table
+ *   6) extract data
+ *   7) delete compressor
+ *
+ *   You will also have to update the first 8 bytes of the compressed data, as it is the offset the chunk table
+ */
+typedef void *LazPerf_VlrCompressorPtr;
+
+/**
+ * Creates a new VlrCompressor
+ *
+ * @param schema : schema of the points to be compressed
+ * @return the new instance
+ */
+LazPerf_VlrCompressorPtr lazperf_new_vlr_compressor(LazPerf_RecordSchemaPtr schema);
+
+/**
+ * Callback receiving compressed data, 'data' is only valid during the call
+ */
+typedef void (*LazPerf_WriteCallback)(void *user_data, const uint8_t *data, size_t size);
+
+/**
+ * Callback asked to overwrite 'size' bytes of data previously given to the write callback,
+ * 'offset' is relative to the first byte that was given to the write callback.
+ */
+typedef void (*LazPerf_PatchCallback)(void *user_data, uint64_t offset, const uint8_t *data, size_t size);
+
+/**
+ * Creates a new VlrCompressor that streams its output to callbacks
+ * instead of accumulating it in its internal buffer.
+ *
+ * Each time a chunk of points is finished, its bytes are given to 'write_callback',
+ * so the internal buffer never holds more than one chunk.
+ * When 'lazperf_vlr_compressor_done' is called, the last chunk is given to 'write_callback'.
+ * When 'lazperf_vlr_compressor_write_chunk_table' is called, the chunk table is given to 'write_callback'
+ * then 'patch_callback' is called to overwrite the first 8 bytes with the offset to the chunk table.
+ *
+ * With such a compressor, there is no need to extract data from the internal buffer.
+ *
+ * @param schema : schema of the points to be compressed
+ * @param offset_to_point_data : offset in bytes to the start of point records
+ * (needed to compute the offset to the chunk table)
+ * @param write_callback : receives the compressed data
+ * @param patch_callback : overwrites the offset to the chunk table
+ * @param user_data : given to the callbacks
+ * @return the new instance
+ */
+LazPerf_VlrCompressorPtr lazperf_new_vlr_compressor_with_sink(
+		LazPerf_RecordSchemaPtr schema,
+		size_t offset_to_point_data,
+		LazPerf_WriteCallback write_callback,
+		LazPerf_PatchCallback patch_callback,
+		void *user_data
+);
+
+/**
+ * Delete the compressor instance
+ *
+ * @param compressor the instance to delete
+ */
+void lazperf_delete_vlr_compressor(LazPerf_VlrCompressorPtr compressor);
+
+/**
+ * Compress one point
+ *
+ * @param compressor the compressor instance
+ * @param inbuf point to compress, if the 'inbuf''s size is less than the point size specified by the
+ * record schema used when creating the instance, you'll get UB
+ * @return the size of the internal buffer after the point was compressed
  */
 size_t lazperf_vlr_compressor_compress(LazPerf_VlrCompressorPtr compressor, const char *inbuf);
 
+/**
+ * Compress 'num_points' points
+ *
+ * This has the same effect as calling 'lazperf_vlr_compressor_compress' 'num_points' times,
+ * but with a lot less overhead per point.
+ *
+ * @param compressor the compressor instance
+ * @param num_points number of points to compress
+ * @param inbuf points to compress, must be at least num_points * point_size bytes
+ * @return the size of the internal buffer after the points were compressed, an error if they could not be
+ */
+struct LazPerf_SizeResult lazperf_vlr_compressor_compress_many(
+		LazPerf_VlrCompressorPtr compressor,
+		size_t num_points,
+		const char *inbuf
+);
+
+/**
+ * Makes the compressor compute the bounds and gps time range of each chunk
+ * as it compresses the points, must be called before any point is compressed.
+ *
+ * The index is retrieved with 'lazperf_vlr_compressor_chunk_index_data' once the compressor is done.
+ *
+ * @param compressor the compressor instance
+ * @return the result, an error if points were already compressed
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_enable_chunk_index(LazPerf_VlrCompressorPtr compressor);
+
+/**
+ * Returns the serialized chunk index, one entry per chunk closed so far,
+ * to be called after 'lazperf_vlr_compressor_done'.
+ * The data is small (40 bytes per chunk), and can be parsed back with 'lazperf_parse_chunk_index'.
+ *
+ * @param compressor the compressor instance, with the chunk index enabled
+ * @return the index data, an empty buffer if the chunk index is not enabled
+ */
+struct LazPerf_SizedBuffer lazperf_vlr_compressor_chunk_index_data(LazPerf_VlrCompressorPtr compressor);
+
+/**
+ * Makes the compressor record statistics about each chunk, must be called before any point is compressed.
+ * When the statistics are not enabled, they cost nothing.
+ *
+ * @param compressor the compressor instance
+ * @param measure_item_bytes whether to estimate the compressed bytes of each record item,
+ * which is expensive: the points are compressed once more per item
+ * @return the result, an error if points were already compressed
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_enable_stats(LazPerf_VlrCompressorPtr compressor, int measure_item_bytes);
+
+/**
+ * Returns the statistics recorded so far, no chunks if they are not enabled
+ */
+struct LazPerf_Stats lazperf_vlr_compressor_stats(LazPerf_VlrCompressorPtr compressor);
+
+/**
+ * Returns a chunk size suited to compressing 'expected_point_count' points that are going to be
+ * decompressed by 'num_threads' threads: enough chunks for each thread to get a few of them,
+ * but chunks between 10 000 and 500 000 points, so that they still compress well and seeking stays cheap.
+ *
+ * @param expected_point_count number of points that will be compressed (an estimate is fine)
+ * @param num_threads number of threads of the readers, 0 for as many as this machine supports
+ */
+uint32_t lazperf_auto_chunk_size(uint64_t expected_point_count, size_t num_threads);
+
+/**
+ * Sets the number of points per chunk, instead of the default of the laszip vlr (50 000).
+ * Smaller chunks give more parallelism and cheaper seeks, larger chunks compress slightly better.
+ *
+ * Must be called before any point is compressed, and before the vlr data is retrieved.
+ *
+ * @param compressor the compressor instance
+ * @param chunk_size number of points per chunk
+ * @return the result, an error if points were already compressed or if chunk_size is 0 or 0xFFFFFFFF
+ * (variable size chunks are enabled with 'lazperf_vlr_compressor_enable_variable_chunks')
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_set_chunk_size(LazPerf_VlrCompressorPtr compressor, uint32_t chunk_size);
+
+/**
+ * Sets the chunk size picked by 'lazperf_auto_chunk_size'
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_set_auto_chunk_size(
+		LazPerf_VlrCompressorPtr compressor,
+		uint64_t expected_point_count,
+		size_t num_threads);
+
+/**
+ * Makes the compressor write variable size chunks: a chunk holds all the points compressed
+ * until 'lazperf_vlr_compressor_close_chunk' is called, and the chunk table stores the number of
+ * points of each chunk (the chunk size of the laszip vlr is then 0xFFFFFFFF, as LASzip does).
+ *
+ * Must be called before any point is compressed, and before the vlr data is retrieved.
+ * Decompressing variable size chunks needs the chunk table
+ * (see 'lazperf_vlr_decompressor_read_chunk_table').
+ *
+ * @param compressor the compressor instance
+ * @return the result, an error if points were already compressed
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_enable_variable_chunks(LazPerf_VlrCompressorPtr compressor);
+
+/**
+ * Closes the current chunk, the next compressed point starts a new one.
+ * Does nothing if no point was compressed since the last chunk was closed.
+ *
+ * @param compressor the compressor instance, with variable size chunks enabled
+ * @return the result, an error if the chunks do not have a variable size
+ */
+struct LazPerf_VoidResult lazperf_vlr_compressor_close_chunk(LazPerf_VlrCompressorPtr compressor);
+
 /**
  * Returns the size (in bytes) of the compressor's internal buffer
  *
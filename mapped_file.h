@@ -0,0 +1,183 @@
+#ifndef LAZPERF_C_MAPPED_FILE_H
+#define LAZPERF_C_MAPPED_FILE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * A file mapped read-only in memory
+ */
+class MappedFile
+{
+public:
+	enum class Access
+	{
+		Normal,
+		Sequential,
+		Random,
+		WillNeed
+	};
+
+	explicit MappedFile(const char *path) : m_data(nullptr), m_size(0)
+	{
+#ifdef _WIN32
+		m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							 FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error(std::string("Failed to open ") + path);
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size))
+		{
+			CloseHandle(m_file);
+			throw std::runtime_error(std::string("Failed to get the size of ") + path);
+		}
+		m_size = (size_t) size.QuadPart;
+		m_mapping = nullptr;
+		if (m_size == 0)
+		{
+			return;
+		}
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr)
+		{
+			CloseHandle(m_file);
+			throw std::runtime_error(std::string("Failed to map ") + path);
+		}
+		m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data == nullptr)
+		{
+			CloseHandle(m_mapping);
+			CloseHandle(m_file);
+			throw std::runtime_error(std::string("Failed to map ") + path);
+		}
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd == -1)
+		{
+			throw std::runtime_error(std::string("Failed to open ") + path + ": " + std::strerror(errno));
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1)
+		{
+			int error = errno;
+			close(fd);
+			throw std::runtime_error(std::string("Failed to stat ") + path + ": " + std::strerror(error));
+		}
+		m_size = (size_t) st.st_size;
+		if (m_size == 0)
+		{
+			close(fd);
+			return;
+		}
+		void *data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		int error = errno;
+		// The mapping stays valid once the file descriptor is closed
+		close(fd);
+		if (data == MAP_FAILED)
+		{
+			throw std::runtime_error(std::string("Failed to map ") + path + ": " + std::strerror(error));
+		}
+		m_data = static_cast<const uint8_t *>(data);
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+		}
+		CloseHandle(m_file);
+#else
+		if (m_data)
+		{
+			munmap(const_cast<uint8_t *>(m_data), m_size);
+		}
+#endif
+	}
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const uint8_t *data() const
+	{ return m_data; }
+
+	size_t size() const
+	{ return m_size; }
+
+	/**
+	 * Tells the OS how the [offset, offset + length) range is going to be accessed,
+	 * so that it can read ahead or not. This is only a hint, it does nothing on Windows.
+	 */
+	void advise(Access access, size_t offset, size_t length) const
+	{
+#ifndef _WIN32
+		if (!m_data || offset >= m_size)
+		{
+			return;
+		}
+		length = std::min(length, m_size - offset);
+
+		// madvise needs a page aligned address
+		size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+		size_t alignedOffset = offset - offset % pageSize;
+		length += offset - alignedOffset;
+
+		int advice = MADV_NORMAL;
+		switch (access)
+		{
+			case Access::Normal:
+				advice = MADV_NORMAL;
+				break;
+			case Access::Sequential:
+				advice = MADV_SEQUENTIAL;
+				break;
+			case Access::Random:
+				advice = MADV_RANDOM;
+				break;
+			case Access::WillNeed:
+				advice = MADV_WILLNEED;
+				break;
+		}
+		madvise(const_cast<uint8_t *>(m_data) + alignedOffset, length, advice);
+#else
+		(void) access;
+		(void) offset;
+		(void) length;
+#endif
+	}
+
+private:
+	const uint8_t *m_data;
+	size_t m_size;
+#ifdef _WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#endif
+};
+
+#endif //LAZPERF_C_MAPPED_FILE_H
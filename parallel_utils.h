@@ -0,0 +1,89 @@
+#ifndef LAZPERF_C_PARALLEL_UTILS_H
+#define LAZPERF_C_PARALLEL_UTILS_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Returns the number of threads to use when the user asked for 'requested' threads,
+ * 0 meaning "as many as the hardware supports"
+ */
+inline size_t resolveThreadCount(size_t requested)
+{
+	if (requested != 0)
+	{
+		return requested;
+	}
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads == 0 ? 1 : hardwareThreads;
+}
+
+/**
+ * Calls 'fn(i)' for each i in [0, count) using up to 'numThreads' threads (the calling thread included).
+ *
+ * Indices are handed out one at a time, so work items of uneven cost still balance out.
+ * If 'fn' throws, the remaining indices are abandoned and the first exception
+ * is rethrown once all threads are joined.
+ */
+template<typename Fn>
+void parallelFor(size_t count, size_t numThreads, Fn fn)
+{
+	numThreads = std::min(resolveThreadCount(numThreads), count);
+	if (numThreads <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			fn(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count && !failed; i = next++)
+		{
+			try
+			{
+				fn(i);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error)
+				{
+					error = std::current_exception();
+				}
+				failed = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (size_t i = 1; i < numThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+#endif //LAZPERF_C_PARALLEL_UTILS_H
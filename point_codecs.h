@@ -0,0 +1,219 @@
+#ifndef LAZPERF_C_POINT_CODECS_H
+#define LAZPERF_C_POINT_CODECS_H
+
+#include <laz-perf/formats.hpp>
+#include <laz-perf/factory.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * Point layouts with a codec specialized at compile time, the others go through laz-perf's dynamic codec
+ */
+enum class PointLayout
+{
+	Dynamic,
+	Point,
+	PointGpsTime,
+	PointRgb,
+	PointGpsTimeRgb,
+};
+
+inline PointLayout pointLayout(const laszip::factory::record_schema &schema)
+{
+	typedef laszip::factory::record_item Item;
+
+	const std::vector<Item> &items = schema.records;
+	if (items.empty() || items.size() > 3 || items[0] != Item::point())
+	{
+		return PointLayout::Dynamic;
+	}
+	if (items.size() == 1)
+	{
+		return PointLayout::Point;
+	}
+	if (items.size() == 2)
+	{
+		if (items[1] == Item::gpstime())
+		{
+			return PointLayout::PointGpsTime;
+		}
+		return items[1] == Item::rgb() ? PointLayout::PointRgb : PointLayout::Dynamic;
+	}
+	return items[1] == Item::gpstime() && items[2] == Item::rgb() ? PointLayout::PointGpsTimeRgb
+																	: PointLayout::Dynamic;
+}
+
+
+/**
+ * Destroys a codec built either on the heap or in a codec storage (see PointCompressorStorage)
+ */
+class CodecDeleter
+{
+public:
+	explicit CodecDeleter(bool inPlace = false) : m_inPlace(inPlace)
+	{}
+
+	template<typename T>
+	void operator()(T *codec) const
+	{
+		if (m_inPlace)
+		{
+			codec->~T();
+		}
+		else
+		{
+			delete codec;
+		}
+	}
+
+private:
+	bool m_inPlace;
+};
+
+
+/**
+ * Compresses runs of points, so that the codec is dispatched once per run rather than once per point
+ */
+template<typename TEncoder>
+class PointCompressor
+{
+public:
+	typedef std::unique_ptr<PointCompressor, CodecDeleter> ptr;
+
+	virtual ~PointCompressor() = default;
+
+	virtual void compressMany(const char *points, size_t count, size_t pointSize) = 0;
+};
+
+/**
+ * Codec of one of the layouts of PointLayout, whose field coders get inlined in the loop over the points
+ */
+template<typename TEncoder, typename... TFields>
+class StaticPointCompressor : public PointCompressor<TEncoder>
+{
+public:
+	explicit StaticPointCompressor(TEncoder &encoder) : m_encoder(encoder)
+	{}
+
+	void compressMany(const char *points, size_t count, size_t pointSize) override
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_record.compressWith(m_encoder, points);
+			points += pointSize;
+		}
+	}
+
+private:
+	TEncoder &m_encoder;
+	laszip::formats::record_compressor<laszip::formats::field<TFields>...> m_record;
+};
+
+template<typename TEncoder>
+class DynamicPointCompressor : public PointCompressor<TEncoder>
+{
+public:
+	explicit DynamicPointCompressor(laszip::formats::dynamic_compressor::ptr compressor)
+			: m_compressor(std::move(compressor))
+	{}
+
+	void compressMany(const char *points, size_t count, size_t pointSize) override
+	{
+		laszip::formats::dynamic_compressor &compressor = *m_compressor;
+		for (size_t i = 0; i < count; ++i)
+		{
+			compressor.compress(points);
+			points += pointSize;
+		}
+	}
+
+private:
+	laszip::formats::dynamic_compressor::ptr m_compressor;
+};
+
+
+/**
+ * Decompresses runs of points, see PointCompressor
+ */
+template<typename TDecoder>
+class PointDecompressor
+{
+public:
+	typedef std::unique_ptr<PointDecompressor, CodecDeleter> ptr;
+
+	virtual ~PointDecompressor() = default;
+
+	virtual void decompressMany(char *out, size_t count, size_t pointSize) = 0;
+};
+
+template<typename TDecoder, typename... TFields>
+class StaticPointDecompressor : public PointDecompressor<TDecoder>
+{
+public:
+	explicit StaticPointDecompressor(TDecoder &decoder) : m_decoder(decoder)
+	{}
+
+	void decompressMany(char *out, size_t count, size_t pointSize) override
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_record.decompressWith(m_decoder, out);
+			out += pointSize;
+		}
+	}
+
+private:
+	TDecoder &m_decoder;
+	laszip::formats::record_decompressor<laszip::formats::field<TFields>...> m_record;
+};
+
+template<typename TDecoder>
+class DynamicPointDecompressor : public PointDecompressor<TDecoder>
+{
+public:
+	explicit DynamicPointDecompressor(laszip::formats::dynamic_decompressor::ptr decompressor)
+			: m_decompressor(std::move(decompressor))
+	{}
+
+	void decompressMany(char *out, size_t count, size_t pointSize) override
+	{
+		laszip::formats::dynamic_decompressor &decompressor = *m_decompressor;
+		for (size_t i = 0; i < count; ++i)
+		{
+			decompressor.decompress(out);
+			out += pointSize;
+		}
+	}
+
+private:
+	laszip::formats::dynamic_decompressor::ptr m_decompressor;
+};
+
+
+
+/**
+ * Room for any of the static codecs, so that the codec of a chunk is built without allocating.
+ * It must outlive the codec built in it, and hold one codec at a time.
+ */
+template<typename TEncoder>
+using PointCompressorStorage = typename std::aligned_union<
+		0,
+		StaticPointCompressor<TEncoder, laszip::formats::las::point10>,
+		StaticPointCompressor<TEncoder, laszip::formats::las::point10, laszip::formats::las::gpstime>,
+		StaticPointCompressor<TEncoder, laszip::formats::las::point10, laszip::formats::las::rgb>,
+		StaticPointCompressor<TEncoder, laszip::formats::las::point10, laszip::formats::las::gpstime,
+							  laszip::formats::las::rgb>>::type;
+
+template<typename TDecoder>
+using PointDecompressorStorage = typename std::aligned_union<
+		0,
+		StaticPointDecompressor<TDecoder, laszip::formats::las::point10>,
+		StaticPointDecompressor<TDecoder, laszip::formats::las::point10, laszip::formats::las::gpstime>,
+		StaticPointDecompressor<TDecoder, laszip::formats::las::point10, laszip::formats::las::rgb>,
+		StaticPointDecompressor<TDecoder, laszip::formats::las::point10, laszip::formats::las::gpstime,
+								laszip::formats::las::rgb>>::type;
+
+#endif //LAZPERF_C_POINT_CODECS_H
@@ -0,0 +1,91 @@
+#ifndef LAZPERF_C_STATS_H
+#define LAZPERF_C_STATS_H
+
+#include "lazperf_c.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Adds the time spent in its scope to '*seconds', does nothing (not even reading the clock) when 'seconds' is null
+ */
+class ScopedTimer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	explicit ScopedTimer(double *seconds) : m_seconds(seconds)
+	{
+		if (m_seconds)
+		{
+			m_start = Clock::now();
+		}
+	}
+
+	~ScopedTimer()
+	{
+		if (m_seconds)
+		{
+			*m_seconds += std::chrono::duration<double>(Clock::now() - m_start).count();
+		}
+	}
+
+	ScopedTimer(const ScopedTimer &) = delete;
+
+	ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+	double *m_seconds;
+	Clock::time_point m_start;
+};
+
+
+/**
+ * Statistics of the chunks compressed or decompressed so far, the last one being the current chunk
+ */
+class ChunkStatsRecorder
+{
+public:
+	/**
+	 * @param numItems number of record items whose compressed bytes are measured, 0 if they are not
+	 */
+	explicit ChunkStatsRecorder(size_t numItems) : m_numItems(numItems)
+	{}
+
+	LazPerf_ChunkStats &startChunk(uint64_t firstPoint)
+	{
+		LazPerf_ChunkStats stats{};
+		stats.first_point = firstPoint;
+		m_chunks.push_back(stats);
+		return m_chunks.back();
+	}
+
+	/**
+	 * Starts a chunk following the current one
+	 */
+	LazPerf_ChunkStats &startNextChunk()
+	{
+		uint64_t firstPoint = m_chunks.empty() ? 0 : m_chunks.back().first_point + m_chunks.back().point_count;
+		return startChunk(firstPoint);
+	}
+
+	LazPerf_ChunkStats *current()
+	{ return m_chunks.empty() ? nullptr : &m_chunks.back(); }
+
+	LazPerf_Stats view() const
+	{
+		LazPerf_Stats stats{};
+		stats.num_chunks = m_chunks.size();
+		stats.chunks = m_chunks.data();
+		stats.num_items = m_numItems;
+		return stats;
+	}
+
+private:
+	size_t m_numItems;
+	std::vector<LazPerf_ChunkStats> m_chunks;
+};
+
+#endif //LAZPERF_C_STATS_H
@@ -1,14 +1,29 @@
 #ifndef LAZPERF_C_STREAM_UTILS_H
 #define LAZPERF_C_STREAM_UTILS_H
 
+#include "allocator.h"
+#include "stats.h"
+
 #include <vector>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_MSC_VER)
+#define LAZPERF_NOINLINE __declspec(noinline)
+#else
+#define LAZPERF_NOINLINE __attribute__((noinline))
+#endif
 
 template<typename CTYPE = unsigned char>
 class TypedLazPerfBuf
 {
-	typedef std::vector<CTYPE> LazPerfRawBuf;
+	typedef std::vector<CTYPE, LazPerfAllocator<CTYPE>> LazPerfRawBuf;
 
 public:
 	LazPerfRawBuf &m_buf;
@@ -36,36 +51,314 @@ public:
 };
 
 
+/**
+ * Output stream writing directly into memory provided by the caller.
+ * Throws if the memory is too small.
+ */
+class WriteOnlyStream
+{
+public:
+	uint8_t *m_data;
+	size_t m_capacity;
+	size_t m_idx;
+
+	WriteOnlyStream(uint8_t *data, size_t capacity)
+			: m_data(data), m_capacity(capacity), m_idx(0)
+	{}
+
+	void putBytes(const unsigned char *b, size_t len)
+	{
+		if (len > m_capacity - m_idx)
+		{
+			throw std::runtime_error("Output buffer is too small");
+		}
+		std::memcpy(&m_data[m_idx], b, len);
+		m_idx += len;
+	}
+
+	void putByte(const unsigned char b)
+	{
+		if (m_idx >= m_capacity)
+		{
+			throw std::runtime_error("Output buffer is too small");
+		}
+		m_data[m_idx++] = b;
+	}
+
+	size_t totalWritten() const
+	{
+		return m_idx;
+	}
+};
+
+
+/**
+ * Pulls data from a user read callback, block by block.
+ *
+ * While the caller consumes a block, the next one is read on a background thread,
+ * so reading overlaps with decoding. Only two blocks are ever held in memory.
+ * The thread is started with the first block and reads every block, it waits for the next request
+ * in between instead of a thread being started per block.
+ */
+class PrefetchingSource
+{
+public:
+	typedef size_t (*ReadFn)(void *userData, uint8_t *buffer, size_t size);
+
+	PrefetchingSource(ReadFn read, void *userData, size_t blockSize)
+			: m_read(read), m_userData(userData), m_front(blockSize), m_back(blockSize), m_measureWaits(false),
+			  m_waitSeconds(0), m_pending(false), m_requested(false), m_ready(false), m_stop(false), m_readSize(0)
+	{
+		if (blockSize == 0)
+		{
+			throw std::invalid_argument("Block size must not be 0");
+		}
+	}
+
+	PrefetchingSource(const PrefetchingSource &) = delete;
+
+	PrefetchingSource &operator=(const PrefetchingSource &) = delete;
+
+	~PrefetchingSource()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+		if (m_thread.joinable())
+		{
+			// Waits for the read in progress, if any, as it writes to m_back
+			m_thread.join();
+		}
+	}
+
+	/**
+	 * Waits for the block being read and starts reading the following one.
+	 *
+	 * @param data set to the start of the block
+	 * @return the size of the block, 0 when there is no more data
+	 */
+	size_t next(const uint8_t **data)
+	{
+		if (!m_pending)
+		{
+			startReading();
+		}
+		size_t size;
+		std::exception_ptr error;
+		{
+			ScopedTimer timer(m_measureWaits ? &m_waitSeconds : nullptr);
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]()
+			{ return m_ready; });
+			m_ready = false;
+			m_pending = false;
+			size = m_readSize;
+			std::swap(error, m_error);
+		}
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+		std::swap(m_front, m_back);
+		if (size != 0)
+		{
+			startReading();
+		}
+		*data = m_front.data();
+		return size;
+	}
+
+	/**
+	 * Makes 'next' measure how long it waits for the blocks to be read
+	 */
+	void measureWaits()
+	{ m_measureWaits = true; }
+
+	double waitSeconds() const
+	{ return m_waitSeconds; }
+
+private:
+	/**
+	 * Asks the thread to read the next block into m_back, starting the thread the first time
+	 */
+	void startReading()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requested = true;
+		}
+		m_pending = true;
+		if (!m_thread.joinable())
+		{
+			m_thread = std::thread(&PrefetchingSource::readBlocks, this);
+		}
+		else
+		{
+			m_condition.notify_all();
+		}
+	}
+
+	void readBlocks()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_condition.wait(lock, [this]()
+			{ return m_requested || m_stop; });
+			if (m_stop)
+			{
+				return;
+			}
+			m_requested = false;
+			lock.unlock();
+
+			size_t size = 0;
+			std::exception_ptr error;
+			try
+			{
+				size = m_read(m_userData, m_back.data(), m_back.size());
+				if (size == (size_t) -1)
+				{
+					throw std::runtime_error("Failed to read compressed data");
+				}
+				size = std::min(size, m_back.size());
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			lock.lock();
+			m_readSize = size;
+			m_error = error;
+			m_ready = true;
+			m_condition.notify_all();
+		}
+	}
+
+	ReadFn m_read;
+	void *m_userData;
+	ByteBuffer m_front;
+	ByteBuffer m_back;
+	bool m_measureWaits;
+	double m_waitSeconds;
+	// Whether a block was requested and not yet returned by 'next', only used by the caller's thread
+	bool m_pending;
+
+	// Shared with the reading thread
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_requested;
+	bool m_ready;
+	bool m_stop;
+	size_t m_readSize;
+	std::exception_ptr m_error;
+	std::thread m_thread;
+};
+
+
+/**
+ * Input stream of the arithmetic decoder, over a buffer or over the blocks of a PrefetchingSource.
+ *
+ * The decoder reads its input byte by byte, so the common case (the byte is in the current block)
+ * is a single pointer comparison, the rest (next block, end of data) is kept out of line.
+ */
 class ReadOnlyStream
 {
 public:
 	const uint8_t *m_data;
 	size_t m_dataLength;
-	size_t m_idx;
+	// When set, data is pulled from it once m_data is exhausted
+	PrefetchingSource *m_source;
+	// Position of m_data in the whole data, when it comes from m_source
+	uint64_t m_blockStart;
 
 	ReadOnlyStream(const uint8_t *data, size_t dataLen)
-			: m_data(data), m_dataLength(dataLen), m_idx(0)
+			: m_data(data), m_dataLength(dataLen), m_source(nullptr), m_blockStart(0), m_cur(data),
+			  m_end(data + dataLen)
+	{}
+
+	explicit ReadOnlyStream(PrefetchingSource *source)
+			: m_data(nullptr), m_dataLength(0), m_source(source), m_blockStart(0), m_cur(nullptr), m_end(nullptr)
 	{}
 
+	/**
+	 * Makes the stream read from another buffer, from its start
+	 */
+	void reset(const uint8_t *data, size_t dataLen)
+	{
+		m_data = data;
+		m_dataLength = dataLen;
+		m_blockStart = 0;
+		m_cur = data;
+		m_end = data + dataLen;
+	}
+
+	/**
+	 * Moves to 'offset' in the current buffer, which must be within the buffer
+	 */
+	void seek(size_t offset)
+	{
+		if (offset > m_dataLength)
+		{
+			throw std::runtime_error("Tried to seek past buffer bounds");
+		}
+		m_cur = m_data + offset;
+	}
+
+	/**
+	 * Number of bytes read so far
+	 */
+	uint64_t position() const
+	{ return m_blockStart + (uint64_t) (m_cur - m_data); }
+
 
 	unsigned char getByte()
 	{
-		if (m_idx >= m_dataLength)
+		if (m_cur == m_end)
 		{
-			throw std::runtime_error("Tried to read past buffer bounds");
+			refill();
 		}
-		return (unsigned char) m_data[m_idx++];
+		return *m_cur++;
 	}
 
 	void getBytes(unsigned char *b, int len)
 	{
-		if (m_idx + len > m_dataLength)
+		size_t remaining = (size_t) len;
+		while (remaining > (size_t) (m_end - m_cur))
+		{
+			size_t available = (size_t) (m_end - m_cur);
+			std::memcpy(b, m_cur, available);
+			b += available;
+			remaining -= available;
+			m_cur += available;
+			refill();
+		}
+		std::memcpy(b, m_cur, remaining);
+		m_cur += remaining;
+	}
+
+private:
+	LAZPERF_NOINLINE void refill()
+	{
+		if (!m_source)
 		{
 			throw std::runtime_error("Tried to read past buffer bounds");
 		}
-		std::memcpy(b, (unsigned char *) &m_data[m_idx], len);
-		m_idx += len;
+		m_blockStart += m_dataLength;
+		if ((m_dataLength = m_source->next(&m_data)) == 0)
+		{
+			m_cur = m_end = m_data;
+			throw std::runtime_error("Tried to read past buffer bounds");
+		}
+		m_cur = m_data;
+		m_end = m_data + m_dataLength;
 	}
+
+	const uint8_t *m_cur;
+	const uint8_t *m_end;
 };
 
 
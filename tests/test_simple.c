@@ -322,39 +322,2011 @@ int test_streaming_compression()
 	}
 
 	lazperf_delete_vlr_compressor(compressor);
-	free(vlr_data.data);
+	lazperf_delete_sized_buffer(vlr_data);
 	free(compressed_output);
 	free(uncompressed_points);
 	return EXIT_SUCCESS;
 }
 
-int test_laz_vlr()
+int test_parallel_decompression()
 {
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
 	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
 	lazperf_record_schema_push_point(record_schema);
 	lazperf_record_schema_push_gpstime(record_schema);
 	lazperf_record_schema_push_rgb(record_schema);
 
+	// Small chunks, so that the points are spread over several threads
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
 
-	struct LazPerf_SizedBuffer vlr_data_1 = lazperf_record_schema_laz_vlr_data(record_schema);
-	LazPerf_LazVlrPtr vlr = lazperf_new_laz_vlr_from_schema(record_schema);
-	size_t data_size = lazperf_laz_vlr_record_data_size(vlr);
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_decompress_points_parallel(
+			lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET,
+			lazperf_vlr_compressor_internal_buffer_size(compressor) - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laz_vlr_data.data,
+			POINT_COUNT,
+			34,
+			(uint8_t *) decompressed_points,
+			4
+	);
 
-	assert(data_size == vlr_data_1.size);
-	char *out = malloc(sizeof(char) * data_size);
-	lazperf_laz_vlr_copy_record_data(vlr, out);
+	if (decomp_result.is_error)
+	{
+		printf("Failed to decompress: %s\n", decomp_result.error.error_msg);
+		lazperf_delete_void_result(&decomp_result);
+		return EXIT_FAILURE;
+	}
 
-	for (int i = 0; i < data_size; ++i)
+	for (size_t i = 0; i < 36210; ++i)
 	{
-		assert(out[i] == vlr_data_1.data[i]);
+		assert(uncompressed_points[i] == decompressed_points[i]);
 	}
-	free(out);
-	lazperf_delete_sized_buffer(vlr_data_1);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+
+	// Without points, the chunk table still has the single empty chunk
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 0);
+	assert(!result.is_error);
+	chunk_table_offset = lazperf_read_chunk_table_offset((uint8_t *) result.points_buffer.data, OFFSET_TO_POINT_DATA);
+	laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	decomp_result = lazperf_decompress_points_parallel(
+			(uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laz_vlr_data.data,
+			0,
+			34,
+			(uint8_t *) decompressed_points,
+			4
+	);
+	if (decomp_result.is_error)
+	{
+		printf("Failed to decompress no points: %s\n", decomp_result.error.error_msg);
+		lazperf_delete_void_result(&decomp_result);
+		return EXIT_FAILURE;
+	}
+
+	lazperf_delete_result(&result);
+	lazperf_delete_sized_buffer(laz_vlr_data);
 	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+int test_parallel_compression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult serial_result = lazperf_compress_points(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT);
+	struct LazPerf_BufferResult parallel_result = lazperf_compress_points_parallel(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, 0, 4);
+
+	if (serial_result.is_error || parallel_result.is_error)
+	{
+		printf("Error when compressing\n");
+		lazperf_delete_result(&serial_result);
+		lazperf_delete_result(&parallel_result);
+		return EXIT_FAILURE;
+	}
+
+	assert(serial_result.points_buffer.size == parallel_result.points_buffer.size);
+	for (size_t i = 0; i < serial_result.points_buffer.size; ++i)
+	{
+		assert(serial_result.points_buffer.data[i] == parallel_result.points_buffer.data[i]);
+	}
+	lazperf_delete_result(&serial_result);
+	lazperf_delete_result(&parallel_result);
+
+	// Several chunks, the same ones a VlrCompressor with that chunk size writes
+	parallel_result = lazperf_compress_points_parallel(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, 100, 4);
+	assert(!parallel_result.is_error);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+	assert(lazperf_vlr_compressor_internal_buffer_size(compressor) == parallel_result.points_buffer.size);
+	assert(memcmp(lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET,
+				  parallel_result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+				  parallel_result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET) == 0);
+	assert(lazperf_read_chunk_table_offset((uint8_t *) parallel_result.points_buffer.data, OFFSET_TO_POINT_DATA)
+		   == chunk_table_offset);
+	lazperf_delete_vlr_compressor(compressor);
+
+	LazPerf_LazVlrPtr vlr = lazperf_new_laz_vlr_from_schema(record_schema);
+	struct LazPerf_VoidResult set_result = lazperf_laz_vlr_set_chunk_size(vlr, UINT32_MAX);
+	assert(set_result.is_error);
+	lazperf_delete_void_result(&set_result);
+	set_result = lazperf_laz_vlr_set_chunk_size(vlr, 100);
+	assert(!set_result.is_error);
+	char *laz_vlr_data = malloc(lazperf_laz_vlr_record_data_size(vlr));
+	lazperf_laz_vlr_copy_record_data(vlr, laz_vlr_data);
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_decompress_points_parallel(
+			(uint8_t *) parallel_result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			parallel_result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laz_vlr_data,
+			POINT_COUNT,
+			34,
+			(uint8_t *) decompressed_points,
+			4
+	);
+	assert(!decomp_result.is_error);
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+	lazperf_delete_result(&parallel_result);
+
+	parallel_result = lazperf_compress_points_parallel(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, UINT32_MAX, 4);
+	assert(parallel_result.is_error);
+	lazperf_delete_result(&parallel_result);
+
+	free(decompressed_points);
+	free(laz_vlr_data);
 	lazperf_delete_laz_vlr(vlr);
+	lazperf_delete_record_schema(record_schema);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+int test_read_chunk_table()
+{
+	FILE *laz_file = fopen("./tests/data/simple.laz", "rb");
+	if (laz_file == NULL)
+	{
+		perror("fopen() of \"simple.laz\" failed");
+		return EXIT_FAILURE;
+	}
+
+	char *laszip_vlr_data = malloc(LASZIP_VLR_DATA_SIZE * sizeof(char));
+	fseek(laz_file, OFFSET_TO_LASZIP_VLR_DATA, SEEK_SET);
+	fread(laszip_vlr_data, sizeof(char), LASZIP_VLR_DATA_SIZE, laz_file);
+
+	size_t point_data_size = 18217 - OFFSET_TO_POINT_DATA;
+	uint8_t *point_data = malloc(point_data_size * sizeof(uint8_t));
+	fread(point_data, sizeof(uint8_t), point_data_size, laz_file);
+	assert(ftell(laz_file) == 18217);
+
+	uint64_t chunk_table_offset = lazperf_read_chunk_table_offset(point_data, OFFSET_TO_POINT_DATA);
+	assert(chunk_table_offset < point_data_size - SIZEOF_CHUNK_TABLE_OFFSET);
+
+	struct LazPerf_ChunkTableResult result = lazperf_read_chunk_table(
+			point_data + SIZEOF_CHUNK_TABLE_OFFSET,
+			point_data_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laszip_vlr_data,
+			POINT_COUNT
+	);
+	if (result.is_error)
+	{
+		printf("Failed to read chunk table: %s\n", result.error.error_msg);
+		lazperf_delete_chunk_table_result(&result);
+		return EXIT_FAILURE;
+	}
+
+	assert(result.chunk_table.num_chunks == 1);
+	assert(result.chunk_table.chunks[0].offset == 0);
+	assert(result.chunk_table.chunks[0].compressed_size == chunk_table_offset);
+	assert(result.chunk_table.chunks[0].point_count == POINT_COUNT);
+	assert(result.chunk_table.chunks[0].first_point == 0);
+
+	lazperf_delete_chunk_table_result(&result);
+	free(point_data);
+	free(laszip_vlr_data);
+	fclose(laz_file);
+	return EXIT_SUCCESS;
+}
+
+int test_seek()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 POINT_COUNT);
+	if (result.is_error)
+	{
+		printf("Error when compressing: %s\n", result.error.error_msg);
+		lazperf_delete_result(&result);
+		return EXIT_FAILURE;
+	}
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			(uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+
+	struct LazPerf_VoidResult seek_result = lazperf_vlr_decompressor_seek(decompressor, 10);
+	assert(seek_result.is_error);
+	lazperf_delete_void_result(&seek_result);
+
+	uint64_t chunk_table_offset = lazperf_read_chunk_table_offset(
+			(uint8_t *) result.points_buffer.data, OFFSET_TO_POINT_DATA);
+	struct LazPerf_VoidResult table_result = lazperf_vlr_decompressor_read_chunk_table(
+			decompressor, chunk_table_offset, POINT_COUNT);
+	assert(!table_result.is_error);
+
+	size_t indices[] = {1000, 10, 11, 500, 1064, 0};
+	char point[34];
+	for (size_t i = 0; i < sizeof(indices) / sizeof(indices[0]); ++i)
+	{
+		seek_result = lazperf_vlr_decompressor_seek(decompressor, indices[i]);
+		assert(!seek_result.is_error);
+		lazperf_vlr_decompressor_decompress_one_to(decompressor, point);
+		assert(memcmp(point, uncompressed_points + indices[i] * 34, 34) == 0);
+	}
+
+	seek_result = lazperf_vlr_decompressor_seek(decompressor, POINT_COUNT);
+	assert(seek_result.is_error);
+	lazperf_delete_void_result(&seek_result);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_result(&result);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_record_schema(record_schema);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+int test_batched_compression_decompression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	struct LazPerf_SizeResult compress_result = lazperf_vlr_compressor_compress_many(
+			compressor, 7, uncompressed_points);
+	assert(!compress_result.is_error);
+	compress_result = lazperf_vlr_compressor_compress_many(
+			compressor, POINT_COUNT - 7, uncompressed_points + 7 * 34);
+	assert(!compress_result.is_error);
+	assert(compress_result.size == lazperf_vlr_compressor_internal_buffer_size(compressor));
+	lazperf_vlr_compressor_done(compressor);
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor);
+	const uint8_t *compressed_points = lazperf_vlr_compressor_internal_buffer(compressor);
+
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 POINT_COUNT);
+	assert(!result.is_error);
+	assert(result.points_buffer.size == compressed_size);
+	for (size_t i = SIZEOF_CHUNK_TABLE_OFFSET; i < compressed_size; ++i)
+	{
+		assert((uint8_t) result.points_buffer.data[i] == compressed_points[i]);
+	}
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	size_t runs[] = {1, 300, POINT_COUNT - 301};
+	char *next_point = decompressed_points;
+	for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i)
+	{
+		struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+				decompressor, runs[i], next_point);
+		assert(!decomp_result.is_error);
+		next_point += runs[i] * 34;
+	}
+
+	for (size_t i = 0; i < 36210; ++i)
+	{
+		assert(uncompressed_points[i] == decompressed_points[i]);
+	}
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_result(&result);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+
+	// The codec errors are reported, not printed
+	LazPerf_RecordSchemaPtr rgb_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_rgb(rgb_schema);
+	compressor = lazperf_new_vlr_compressor(rgb_schema);
+	compress_result = lazperf_vlr_compressor_compress_many(compressor, 1, uncompressed_points);
+	assert(compress_result.is_error);
+	lazperf_delete_size_result(&compress_result);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(rgb_schema);
+
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+int test_compression_into()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	size_t bound = lazperf_compress_bound(record_schema, POINT_COUNT, 0);
+	uint8_t *out = malloc(lazperf_compress_bound(record_schema, POINT_COUNT, 100) * sizeof(uint8_t));
+	struct LazPerf_SizeResult result = lazperf_compress_points_into(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, 0, out, bound);
+	if (result.is_error)
+	{
+		printf("Error when compressing: %s\n", result.error.error_msg);
+		lazperf_delete_size_result(&result);
+		return EXIT_FAILURE;
+	}
+
+	struct LazPerf_BufferResult expected = lazperf_compress_points(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT);
+	assert(!expected.is_error);
+	assert(expected.points_buffer.size == result.size);
+	assert(memcmp(expected.points_buffer.data, out, result.size) == 0);
+
+	struct LazPerf_SizeResult too_small = lazperf_compress_points_into(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, 0, out, result.size - 1);
+	assert(too_small.is_error);
+	lazperf_delete_size_result(&too_small);
+	lazperf_delete_result(&expected);
+
+	expected = lazperf_compress_points_parallel(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT, 100, 2);
+	assert(!expected.is_error);
+	result = lazperf_compress_points_into(record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT,
+										  100, out, lazperf_compress_bound(record_schema, POINT_COUNT, 100));
+	assert(!result.is_error);
+	assert(expected.points_buffer.size == result.size);
+	assert(memcmp(expected.points_buffer.data, out, result.size) == 0);
+	lazperf_delete_result(&expected);
+
+	expected = lazperf_compress_points(record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, 0);
+	assert(!expected.is_error);
+	result = lazperf_compress_points_into(record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, 0,
+										  0, out, lazperf_compress_bound(record_schema, 0, 0));
+	assert(!result.is_error);
+	assert(expected.points_buffer.size == result.size);
+	assert(memcmp(expected.points_buffer.data, out, result.size) == 0);
+	lazperf_delete_result(&expected);
+
+	lazperf_delete_record_schema(record_schema);
+	free(out);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
 	return EXIT_SUCCESS;
 }
 
+struct SinkBuffer
+{
+	uint8_t *data;
+	size_t size;
+	size_t num_writes;
+};
+
+void sink_write(void *user_data, const uint8_t *data, size_t size)
+{
+	struct SinkBuffer *sink = user_data;
+	sink->data = realloc(sink->data, sink->size + size);
+	memcpy(sink->data + sink->size, data, size);
+	sink->size += size;
+	sink->num_writes++;
+}
+
+void sink_patch(void *user_data, uint64_t offset, const uint8_t *data, size_t size)
+{
+	struct SinkBuffer *sink = user_data;
+	assert(offset + size <= sink->size);
+	memcpy(sink->data + offset, data, size);
+}
+
+int test_sink_compression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct SinkBuffer sink = {NULL, 0, 0};
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor_with_sink(
+			record_schema, OFFSET_TO_POINT_DATA, sink_write, sink_patch, &sink);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	assert(lazperf_vlr_compressor_done(compressor) == 0);
+	assert(lazperf_vlr_compressor_write_chunk_table(compressor) == 0);
+	assert(lazperf_vlr_compressor_internal_buffer_size(compressor) == 0);
+	assert(sink.num_writes >= 2);
+
+	struct LazPerf_BufferResult expected = lazperf_compress_points(
+			record_schema, OFFSET_TO_POINT_DATA, uncompressed_points, POINT_COUNT);
+	assert(!expected.is_error);
+	assert(expected.points_buffer.size == sink.size);
+	assert(memcmp(expected.points_buffer.data, sink.data, sink.size) == 0);
+
+	lazperf_delete_result(&expected);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(sink.data);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+struct MemorySource
+{
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+};
+
+size_t memory_source_read(void *user_data, uint8_t *buffer, size_t size)
+{
+	struct MemorySource *source = user_data;
+	size_t remaining = source->size - source->pos;
+	size_t count = size < remaining ? size : remaining;
+	memcpy(buffer, source->data + source->pos, count);
+	source->pos += count;
+	return count;
+}
+
+/* Fails instead of reporting the end of the data */
+size_t failing_source_read(void *user_data, uint8_t *buffer, size_t size)
+{
+	struct MemorySource *source = user_data;
+	if (source->pos == source->size)
+	{
+		return (size_t) -1;
+	}
+	return memory_source_read(user_data, buffer, size);
+}
+
+int test_source_decompression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 POINT_COUNT);
+	assert(!result.is_error);
+
+	struct MemorySource source = {
+			(uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			0
+	};
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor_from_source(
+			memory_source_read, &source, 100, 34, laz_vlr_data.data);
+
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, POINT_COUNT, decompressed_points);
+	assert(!decomp_result.is_error);
+
+	for (size_t i = 0; i < 36210; ++i)
+	{
+		assert(uncompressed_points[i] == decompressed_points[i]);
+	}
+	lazperf_delete_vlr_decompressor(decompressor);
+
+	// The read error of the reading thread is reported by the decompressor
+	source.size /= 2;
+	source.pos = 0;
+	decompressor = lazperf_new_vlr_decompressor_from_source(
+			failing_source_read, &source, 100, 34, laz_vlr_data.data);
+	decomp_result = lazperf_vlr_decompressor_decompress_many(decompressor, POINT_COUNT, decompressed_points);
+	assert(decomp_result.is_error);
+	assert(strstr(decomp_result.error.error_msg, "Failed to read") != NULL);
+	lazperf_delete_void_result(&decomp_result);
+	lazperf_delete_vlr_decompressor(decompressor);
+
+	lazperf_delete_result(&result);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	fclose(uncompressed_points_file);
+	return EXIT_SUCCESS;
+}
+
+int test_file_reader()
+{
+	struct LazPerf_FileReaderResult result = lazperf_open_file("./tests/data/simple.laz");
+	if (result.is_error)
+	{
+		printf("Failed to open file: %s\n", result.error.error_msg);
+		lazperf_delete_file_reader_result(&result);
+		return EXIT_FAILURE;
+	}
+	LazPerf_FileReaderPtr reader = result.reader;
+
+	const struct LazPerf_LasHeader *header = lazperf_file_reader_header(reader);
+	assert(header->version_major == 1);
+	assert(header->point_format == 3);
+	assert(header->offset_to_point_data == OFFSET_TO_POINT_DATA);
+	assert(lazperf_file_reader_point_count(reader) == POINT_COUNT);
+	assert(lazperf_file_reader_point_size(reader) == 34);
+
+	size_t compressed_size = 0;
+	const uint8_t *compressed_points = lazperf_file_reader_compressed_points(reader, &compressed_size);
+	assert(compressed_points != NULL);
+	assert(compressed_size == 18217 - OFFSET_TO_POINT_DATA - SIZEOF_CHUNK_TABLE_OFFSET);
+	assert(lazperf_file_reader_chunk_table_offset(reader) < compressed_size);
+
+	lazperf_file_reader_advise(reader, LAZPERF_ACCESS_SEQUENTIAL);
+	struct LazPerf_VlrDecompressorResult decompressor_result = lazperf_file_reader_new_decompressor(reader);
+	assert(!decompressor_result.is_error);
+	LazPerf_VlrDecompressorPtr decompressor = decompressor_result.decompressor;
+	char *decompressed_points = malloc(POINT_COUNT * 34 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, POINT_COUNT, decompressed_points);
+	assert(!decomp_result.is_error);
+
+	FILE *decompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (decompressed_points_file == NULL)
+	{
+		perror("fopen() failed");
+		return EXIT_FAILURE;
+	}
+	char *expected_points = malloc(POINT_COUNT * 34 * sizeof(char));
+	fread(expected_points, sizeof(char), POINT_COUNT * 34, decompressed_points_file);
+	assert(memcmp(expected_points, decompressed_points, POINT_COUNT * 34) == 0);
+
+	char point[34];
+	struct LazPerf_VoidResult seek_result = lazperf_vlr_decompressor_seek(decompressor, 500);
+	assert(!seek_result.is_error);
+	lazperf_vlr_decompressor_decompress_one_to(decompressor, point);
+	assert(memcmp(point, expected_points + 500 * 34, 34) == 0);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_close_file(reader);
+	fclose(decompressed_points_file);
+	free(expected_points);
+	free(decompressed_points);
+
+	// A header claiming more points than the chunk table describes gives an error, not a crash
+	FILE *file = fopen("./tests/data/simple.laz", "rb");
+	char *file_data = malloc(18217 * sizeof(char));
+	fread(file_data, sizeof(char), 18217, file);
+	fclose(file);
+	uint32_t wrong_point_count = POINT_COUNT + 10;
+	memcpy(file_data + 107, &wrong_point_count, sizeof(uint32_t));
+	const char *corrupted_path = "./tests/data/simple_corrupted.laz";
+	file = fopen(corrupted_path, "wb");
+	fwrite(file_data, sizeof(char), 18217, file);
+	fclose(file);
+	free(file_data);
+
+	result = lazperf_open_file(corrupted_path);
+	assert(!result.is_error);
+	decompressor_result = lazperf_file_reader_new_decompressor(result.reader);
+	assert(decompressor_result.is_error);
+	lazperf_delete_vlr_decompressor_result(&decompressor_result);
+	lazperf_close_file(result.reader);
+
+	// A laszip vlr too small for its items is rejected when the file is opened
+	file = fopen("./tests/data/simple.laz", "rb");
+	file_data = malloc(18217 * sizeof(char));
+	fread(file_data, sizeof(char), 18217, file);
+	fclose(file);
+	char *laszip_user_id = NULL;
+	for (size_t i = 0; i + 14 <= 18217 && laszip_user_id == NULL; ++i)
+	{
+		if (memcmp(file_data + i, "laszip encoded", 14) == 0)
+		{
+			laszip_user_id = file_data + i;
+		}
+	}
+	assert(laszip_user_id != NULL);
+	for (int corruption = 0; corruption < 2; ++corruption)
+	{
+		char *corrupted_data = malloc(18217 * sizeof(char));
+		memcpy(corrupted_data, file_data, 18217);
+		char *user_id = corrupted_data + (laszip_user_id - file_data);
+		if (corruption == 0)
+		{
+			// The record length, shorter than the fixed fields
+			uint16_t record_length = 20;
+			memcpy(user_id + 18, &record_length, sizeof(uint16_t));
+		}
+		else
+		{
+			// The number of items, more than the record holds,
+			// past the record id, the record length and the description of the vlr header
+			uint16_t num_items = 100;
+			memcpy(user_id + 16 + 4 + 32 + 32, &num_items, sizeof(uint16_t));
+		}
+		file = fopen(corrupted_path, "wb");
+		fwrite(corrupted_data, sizeof(char), 18217, file);
+		fclose(file);
+		free(corrupted_data);
+
+		result = lazperf_open_file(corrupted_path);
+		if (result.is_error) fprintf(stderr, "DBG %s\n", result.error.error_msg);
+		assert(result.is_error);
+		lazperf_delete_file_reader_result(&result);
+	}
+	free(file_data);
+	remove(corrupted_path);
+	return EXIT_SUCCESS;
+}
+
+int test_file_writer()
+{
+	const char *path = "./tests/data/simple_written.laz";
+	FILE *decompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (decompressed_points_file == NULL)
+	{
+		perror("fopen() failed");
+		return EXIT_FAILURE;
+	}
+	char *points = malloc(POINT_COUNT * 34 * sizeof(char));
+	fread(points, sizeof(char), POINT_COUNT * 34, decompressed_points_file);
+	fclose(decompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_LasHeader header;
+	memset(&header, 0, sizeof(header));
+	header.version_major = 1;
+	header.version_minor = 2;
+	header.point_format = 3;
+	for (int i = 0; i < 3; ++i)
+	{
+		header.scales[i] = 0.01;
+	}
+
+	struct LazPerf_FileWriterResult result = lazperf_create_file(path, record_schema, &header);
+	if (result.is_error)
+	{
+		printf("Failed to create file: %s\n", result.error.error_msg);
+		lazperf_delete_file_writer_result(&result);
+		return EXIT_FAILURE;
+	}
+	LazPerf_FileWriterPtr writer = result.writer;
+
+	const uint8_t vlr_data[4] = {1, 2, 3, 4};
+	struct LazPerf_VoidResult vlr_result = lazperf_file_writer_add_vlr(
+			writer, "test", 42, "a test vlr", vlr_data, sizeof(vlr_data));
+	assert(!vlr_result.is_error);
+
+	// Written in 2 calls, to check that the bounds and counts are accumulated
+	struct LazPerf_VoidResult write_result = lazperf_file_writer_write_points(writer, points, 500);
+	assert(!write_result.is_error);
+	write_result = lazperf_file_writer_write_points(writer, points + 500 * 34, POINT_COUNT - 500);
+	assert(!write_result.is_error);
+
+	vlr_result = lazperf_file_writer_add_vlr(writer, "test", 43, NULL, vlr_data, sizeof(vlr_data));
+	assert(vlr_result.is_error);
+	lazperf_delete_void_result(&vlr_result);
+
+	struct LazPerf_VoidResult finish_result = lazperf_file_writer_finish(writer);
+	assert(!finish_result.is_error);
+	lazperf_delete_file_writer(writer);
+
+	struct LazPerf_FileReaderResult reader_result = lazperf_open_file(path);
+	assert(!reader_result.is_error);
+	LazPerf_FileReaderPtr reader = reader_result.reader;
+
+	const struct LazPerf_LasHeader *written_header = lazperf_file_reader_header(reader);
+	assert(written_header->point_format == 3);
+	assert(written_header->header_size == LAS_HEADER_SIZE);
+	assert(written_header->number_of_vlrs == 2);
+	assert(written_header->offset_to_point_data
+		   == OFFSET_TO_POINT_DATA + VLR_HEADER_SIZE + sizeof(vlr_data));
+	assert(written_header->point_count == POINT_COUNT);
+
+	int32_t mins[3] = {INT32_MAX, INT32_MAX, INT32_MAX};
+	uint64_t points_by_return[5] = {0};
+	for (int i = 0; i < POINT_COUNT; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			int32_t value;
+			memcpy(&value, points + i * 34 + 4 * j, sizeof(int32_t));
+			mins[j] = value < mins[j] ? value : mins[j];
+		}
+		int return_number = points[i * 34 + 14] & 0x07;
+		if (return_number != 0)
+		{
+			points_by_return[return_number - 1]++;
+		}
+	}
+	for (int j = 0; j < 3; ++j)
+	{
+		assert(written_header->mins[j] == mins[j] * 0.01);
+		assert(written_header->mins[j] <= written_header->maxs[j]);
+	}
+	for (int i = 0; i < 5; ++i)
+	{
+		assert(written_header->points_by_return[i] == points_by_return[i]);
+	}
+
+	struct LazPerf_VlrDecompressorResult decompressor_result = lazperf_file_reader_new_decompressor(reader);
+	assert(!decompressor_result.is_error);
+	LazPerf_VlrDecompressorPtr decompressor = decompressor_result.decompressor;
+	char *decompressed_points = malloc(POINT_COUNT * 34 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, POINT_COUNT, decompressed_points);
+	assert(!decomp_result.is_error);
+	assert(memcmp(points, decompressed_points, POINT_COUNT * 34) == 0);
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_close_file(reader);
+	remove(path);
+
+	// A file without points still has the offset to the chunk table and the chunk table
+	result = lazperf_create_file(path, record_schema, &header);
+	assert(!result.is_error);
+	finish_result = lazperf_file_writer_finish(result.writer);
+	assert(!finish_result.is_error);
+	lazperf_delete_file_writer(result.writer);
+
+	reader_result = lazperf_open_file(path);
+	if (reader_result.is_error)
+	{
+		printf("Failed to open the file without points: %s\n", reader_result.error.error_msg);
+		lazperf_delete_file_reader_result(&reader_result);
+		return EXIT_FAILURE;
+	}
+	reader = reader_result.reader;
+	assert(lazperf_file_reader_point_count(reader) == 0);
+	size_t compressed_size = 0;
+	lazperf_file_reader_compressed_points(reader, &compressed_size);
+	assert(lazperf_file_reader_chunk_table_offset(reader) < compressed_size);
+	decompressor_result = lazperf_file_reader_new_decompressor(reader);
+	assert(!decompressor_result.is_error);
+	lazperf_delete_vlr_decompressor(decompressor_result.decompressor);
+	lazperf_close_file(reader);
+	remove(path);
+
+	lazperf_delete_record_schema(record_schema);
+	free(points);
+	free(decompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_columnar_decompression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 POINT_COUNT);
+	assert(!result.is_error);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			(const uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+
+	const double scales[3] = {0.01, 0.01, 0.001};
+	const double offsets[3] = {100.0, -50.0, 0.5};
+	double *x = malloc(POINT_COUNT * sizeof(double));
+	double *z = malloc(POINT_COUNT * sizeof(double));
+	uint8_t *classification = malloc(POINT_COUNT * sizeof(uint8_t));
+	double *gps_time = malloc(POINT_COUNT * sizeof(double));
+	uint16_t *blue = malloc(POINT_COUNT * sizeof(uint16_t));
+
+	struct LazPerf_Columns columns;
+	memset(&columns, 0, sizeof(columns));
+	columns.x = x;
+	columns.z = z;
+	columns.classification = classification;
+	columns.gps_time = gps_time;
+	columns.blue = blue;
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_columns(
+			decompressor, POINT_COUNT, scales, offsets, &columns);
+	assert(!decomp_result.is_error);
+
+	for (size_t i = 0; i < POINT_COUNT; ++i)
+	{
+		const char *point = uncompressed_points + i * 34;
+		int32_t raw_x, raw_z;
+		double expected_gps_time;
+		uint16_t expected_blue;
+		memcpy(&raw_x, point, sizeof(int32_t));
+		memcpy(&raw_z, point + 8, sizeof(int32_t));
+		memcpy(&expected_gps_time, point + 20, sizeof(double));
+		memcpy(&expected_blue, point + 32, sizeof(uint16_t));
+		assert(x[i] == raw_x * scales[0] + offsets[0]);
+		assert(z[i] == raw_z * scales[2] + offsets[2]);
+		assert(classification[i] == (point[15] & 0x1F));
+		assert(gps_time[i] == expected_gps_time);
+		assert(blue[i] == expected_blue);
+	}
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_result(&result);
+	lazperf_delete_record_schema(record_schema);
+	free(uncompressed_points);
+	free(x);
+	free(z);
+	free(classification);
+	free(gps_time);
+	free(blue);
+	return EXIT_SUCCESS;
+}
+
+int test_query_box()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult result = lazperf_compress_points(record_schema,
+																 OFFSET_TO_POINT_DATA,
+																 uncompressed_points,
+																 POINT_COUNT);
+	assert(!result.is_error);
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			(uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	uint64_t chunk_table_offset = lazperf_read_chunk_table_offset(
+			(uint8_t *) result.points_buffer.data, OFFSET_TO_POINT_DATA);
+	struct LazPerf_VoidResult table_result = lazperf_vlr_decompressor_read_chunk_table(
+			decompressor, chunk_table_offset, POINT_COUNT);
+	assert(!table_result.is_error);
+
+	size_t num_chunks = lazperf_vlr_decompressor_num_chunks(decompressor);
+	assert(num_chunks > 0);
+	struct LazPerf_Bounds *chunk_bounds = malloc(num_chunks * sizeof(struct LazPerf_Bounds));
+	struct LazPerf_VoidResult bounds_result = lazperf_vlr_decompressor_compute_chunk_bounds(
+			decompressor, chunk_bounds);
+	assert(!bounds_result.is_error);
+
+	// A box around the X and Y of the 100th point, that contains some of the points
+	struct LazPerf_Bounds box;
+	int32_t center[3];
+	memcpy(center, uncompressed_points + 100 * 34, sizeof(center));
+	for (int j = 0; j < 3; ++j)
+	{
+		box.mins[j] = j < 2 ? center[j] - 2000 : INT32_MIN;
+		box.maxs[j] = j < 2 ? center[j] + 2000 : INT32_MAX;
+	}
+
+	struct LazPerf_BufferResult query_result = lazperf_vlr_decompressor_query_box(decompressor, &box);
+	assert(!query_result.is_error);
+
+	size_t num_matching = 0;
+	for (size_t i = 0; i < POINT_COUNT; ++i)
+	{
+		const char *point = uncompressed_points + i * 34;
+		int32_t xyz[3];
+		memcpy(xyz, point, sizeof(xyz));
+		int inside = 1;
+		for (int j = 0; j < 3; ++j)
+		{
+			inside = inside && xyz[j] >= box.mins[j] && xyz[j] <= box.maxs[j];
+		}
+		if (inside)
+		{
+			assert((num_matching + 1) * 34 <= query_result.points_buffer.size);
+			assert(memcmp(query_result.points_buffer.data + num_matching * 34, point, 34) == 0);
+			num_matching++;
+		}
+	}
+	assert(num_matching > 0);
+	assert(query_result.points_buffer.size == num_matching * 34);
+
+	// Bounds given back to a new decompressor give the same answer
+	LazPerf_VlrDecompressorPtr other_decompressor = lazperf_new_vlr_decompressor(
+			(uint8_t *) result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	table_result = lazperf_vlr_decompressor_read_chunk_table(other_decompressor, chunk_table_offset, POINT_COUNT);
+	assert(!table_result.is_error);
+	bounds_result = lazperf_vlr_decompressor_set_chunk_bounds(other_decompressor, chunk_bounds, num_chunks);
+	assert(!bounds_result.is_error);
+	struct LazPerf_BufferResult other_result = lazperf_vlr_decompressor_query_box(other_decompressor, &box);
+	assert(!other_result.is_error);
+	assert(other_result.points_buffer.size == query_result.points_buffer.size);
+	assert(memcmp(other_result.points_buffer.data, query_result.points_buffer.data,
+				  query_result.points_buffer.size) == 0);
+
+	lazperf_delete_result(&other_result);
+	lazperf_delete_result(&query_result);
+	lazperf_delete_vlr_decompressor(other_decompressor);
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_result(&result);
+	lazperf_delete_record_schema(record_schema);
+	free(chunk_bounds);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_chunk_index()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	struct LazPerf_VoidResult enable_result = lazperf_vlr_compressor_enable_chunk_index(compressor);
+	assert(!enable_result.is_error);
+	lazperf_vlr_compressor_compress(compressor, uncompressed_points);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT - 1, uncompressed_points + 34);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+
+	enable_result = lazperf_vlr_compressor_enable_chunk_index(compressor);
+	assert(enable_result.is_error);
+	lazperf_delete_void_result(&enable_result);
+
+	struct LazPerf_SizedBuffer index_data = lazperf_vlr_compressor_chunk_index_data(compressor);
+	struct LazPerf_ChunkIndexResult index_result = lazperf_parse_chunk_index(
+			(const uint8_t *) index_data.data, index_data.size);
+	assert(!index_result.is_error);
+	struct LazPerf_ChunkIndex index = index_result.chunk_index;
+
+	// The index has the same bounds as the ones the decompressor computes
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor);
+	const uint8_t *compressed_points = lazperf_vlr_compressor_internal_buffer(compressor);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	struct LazPerf_VoidResult table_result = lazperf_vlr_decompressor_read_chunk_table(
+			decompressor, chunk_table_offset, POINT_COUNT);
+	assert(!table_result.is_error);
+	assert(lazperf_vlr_decompressor_num_chunks(decompressor) == index.num_chunks);
+
+	struct LazPerf_Bounds *bounds = malloc(index.num_chunks * sizeof(struct LazPerf_Bounds));
+	struct LazPerf_VoidResult bounds_result = lazperf_vlr_decompressor_compute_chunk_bounds(decompressor, bounds);
+	assert(!bounds_result.is_error);
+	assert(memcmp(bounds, index.bounds, index.num_chunks * sizeof(struct LazPerf_Bounds)) == 0);
+
+	double first_gps_time;
+	memcpy(&first_gps_time, uncompressed_points + 20, sizeof(double));
+	assert(index.min_gps_times[0] <= first_gps_time && first_gps_time <= index.max_gps_times[0]);
+
+	struct LazPerf_ChunkIndexResult bad_result = lazperf_parse_chunk_index(
+			(const uint8_t *) index_data.data, index_data.size - 1);
+	assert(bad_result.is_error);
+	lazperf_delete_chunk_index_result(&bad_result);
+
+	free(bounds);
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_chunk_index_result(&index_result);
+	lazperf_delete_sized_buffer(index_data);
+	lazperf_delete_vlr_compressor(compressor);
+
+	// The index of a file without points has no chunk, like its chunk table
+	compressor = lazperf_new_vlr_compressor(record_schema);
+	enable_result = lazperf_vlr_compressor_enable_chunk_index(compressor);
+	assert(!enable_result.is_error);
+	chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+	index_data = lazperf_vlr_compressor_chunk_index_data(compressor);
+	index_result = lazperf_parse_chunk_index((const uint8_t *) index_data.data, index_data.size);
+	assert(!index_result.is_error);
+	assert(index_result.chunk_index.num_chunks == 0);
+
+	compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor);
+	compressed_points = lazperf_vlr_compressor_internal_buffer(compressor);
+	decompressor = lazperf_new_vlr_decompressor(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	table_result = lazperf_vlr_decompressor_read_chunk_table(decompressor, chunk_table_offset, 0);
+	assert(!table_result.is_error);
+	assert(lazperf_vlr_decompressor_num_chunks(decompressor) == 0);
+	struct LazPerf_VoidResult set_result = lazperf_vlr_decompressor_set_chunk_bounds(
+			decompressor, index_result.chunk_index.bounds, index_result.chunk_index.num_chunks);
+	assert(!set_result.is_error);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_chunk_index_result(&index_result);
+	lazperf_delete_sized_buffer(index_data);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_record_schema(record_schema);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_variable_chunks()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	struct LazPerf_VoidResult close_result = lazperf_vlr_compressor_close_chunk(compressor);
+	assert(close_result.is_error);
+	lazperf_delete_void_result(&close_result);
+
+	struct LazPerf_VoidResult enable_result = lazperf_vlr_compressor_enable_variable_chunks(compressor);
+	assert(!enable_result.is_error);
+
+	size_t chunk_point_counts[] = {10, 1, 300, POINT_COUNT - 311};
+	const char *next_point = uncompressed_points;
+	for (size_t i = 0; i < sizeof(chunk_point_counts) / sizeof(chunk_point_counts[0]); ++i)
+	{
+		lazperf_vlr_compressor_compress_many(compressor, chunk_point_counts[i], next_point);
+		next_point += chunk_point_counts[i] * 34;
+		close_result = lazperf_vlr_compressor_close_chunk(compressor);
+		assert(!close_result.is_error);
+	}
+	// Closing a chunk that has no points does nothing
+	close_result = lazperf_vlr_compressor_close_chunk(compressor);
+	assert(!close_result.is_error);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+	uint32_t vlr_chunk_size;
+	memcpy(&vlr_chunk_size, laz_vlr_data.data + 12, sizeof(uint32_t));
+	assert(vlr_chunk_size == 0xFFFFFFFF);
+
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor);
+	const uint8_t *compressed_points = lazperf_vlr_compressor_internal_buffer(compressor);
+	struct LazPerf_ChunkTableResult table = lazperf_read_chunk_table(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laz_vlr_data.data,
+			POINT_COUNT);
+	assert(!table.is_error);
+	assert(table.chunk_table.num_chunks == 4);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		assert(table.chunk_table.chunks[i].point_count == chunk_point_counts[i]);
+	}
+	lazperf_delete_chunk_table_result(&table);
+
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, 1, decompressed_points);
+	assert(decomp_result.is_error);
+	lazperf_delete_void_result(&decomp_result);
+
+	struct LazPerf_VoidResult table_result = lazperf_vlr_decompressor_read_chunk_table(
+			decompressor, chunk_table_offset, POINT_COUNT);
+	assert(!table_result.is_error);
+	decomp_result = lazperf_vlr_decompressor_decompress_many(decompressor, POINT_COUNT, decompressed_points);
+	assert(!decomp_result.is_error);
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+
+	char point[34];
+	struct LazPerf_VoidResult seek_result = lazperf_vlr_decompressor_seek(decompressor, 305);
+	assert(!seek_result.is_error);
+	lazperf_vlr_decompressor_decompress_one_to(decompressor, point);
+	assert(memcmp(point, uncompressed_points + 305 * 34, 34) == 0);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_laz_vlr()
+{
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+
+	struct LazPerf_SizedBuffer vlr_data_1 = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_LazVlrPtr vlr = lazperf_new_laz_vlr_from_schema(record_schema);
+	size_t data_size = lazperf_laz_vlr_record_data_size(vlr);
+
+	assert(data_size == vlr_data_1.size);
+	char *out = malloc(sizeof(char) * data_size);
+	lazperf_laz_vlr_copy_record_data(vlr, out);
+
+	for (int i = 0; i < data_size; ++i)
+	{
+		assert(out[i] == vlr_data_1.data[i]);
+	}
+	free(out);
+	lazperf_delete_sized_buffer(vlr_data_1);
+	lazperf_delete_record_schema(record_schema);
+	lazperf_delete_laz_vlr(vlr);
+	return EXIT_SUCCESS;
+}
+
+
+int test_chunk_size()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	assert(lazperf_auto_chunk_size(100, 4) == 10000);
+	assert(lazperf_auto_chunk_size(1000000, 4) == 62500);
+	assert(lazperf_auto_chunk_size(10000000000, 4) == 500000);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	struct LazPerf_VoidResult set_result = lazperf_vlr_compressor_set_chunk_size(compressor, 0);
+	assert(set_result.is_error);
+	lazperf_delete_void_result(&set_result);
+	set_result = lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	assert(!set_result.is_error);
+
+	set_result = lazperf_vlr_compressor_set_chunk_size(compressor, UINT32_MAX);
+	assert(set_result.is_error);
+	lazperf_delete_void_result(&set_result);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	set_result = lazperf_vlr_compressor_set_chunk_size(compressor, 200);
+	assert(set_result.is_error);
+	lazperf_delete_void_result(&set_result);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+	uint32_t vlr_chunk_size;
+	memcpy(&vlr_chunk_size, laz_vlr_data.data + 12, sizeof(uint32_t));
+	assert(vlr_chunk_size == 100);
+
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor);
+	const uint8_t *compressed_points = lazperf_vlr_compressor_internal_buffer(compressor);
+	struct LazPerf_ChunkTableResult table = lazperf_read_chunk_table(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			chunk_table_offset,
+			laz_vlr_data.data,
+			POINT_COUNT);
+	assert(!table.is_error);
+	assert(table.chunk_table.num_chunks == (POINT_COUNT + 99) / 100);
+	lazperf_delete_chunk_table_result(&table);
+
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			compressed_points + SIZEOF_CHUNK_TABLE_OFFSET,
+			compressed_size - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, POINT_COUNT, decompressed_points);
+	assert(!decomp_result.is_error);
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_decompressor_reset()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	// Compress the first and the second half of the points as 2 separate tiles,
+	// with small chunks so that each tile is decompressed across many chunks
+	const size_t tile_point_counts[] = {POINT_COUNT / 2, POINT_COUNT - POINT_COUNT / 2};
+	uint8_t *tiles[2];
+	size_t tile_sizes[2];
+	const char *next_point = uncompressed_points;
+	struct LazPerf_SizedBuffer laz_vlr_data;
+	for (size_t i = 0; i < 2; ++i)
+	{
+		LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+		lazperf_vlr_compressor_set_chunk_size(compressor, 50);
+		lazperf_vlr_compressor_compress_many(compressor, tile_point_counts[i], next_point);
+		lazperf_vlr_compressor_done(compressor);
+		tile_sizes[i] = lazperf_vlr_compressor_internal_buffer_size(compressor);
+		tiles[i] = malloc(tile_sizes[i]);
+		memcpy(tiles[i], lazperf_vlr_compressor_internal_buffer(compressor), tile_sizes[i]);
+		if (i == 0)
+		{
+			laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+		}
+		lazperf_delete_vlr_compressor(compressor);
+		next_point += tile_point_counts[i] * 34;
+	}
+
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			tiles[0] + SIZEOF_CHUNK_TABLE_OFFSET,
+			tile_sizes[0] - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	char *next_decompressed = decompressed_points;
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (i > 0)
+		{
+			struct LazPerf_VoidResult reset_result = lazperf_vlr_decompressor_reset(
+					decompressor, tiles[i] + SIZEOF_CHUNK_TABLE_OFFSET, tile_sizes[i] - SIZEOF_CHUNK_TABLE_OFFSET);
+			assert(!reset_result.is_error);
+		}
+		struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+				decompressor, tile_point_counts[i], next_decompressed);
+		assert(!decomp_result.is_error);
+		next_decompressed += tile_point_counts[i] * 34;
+	}
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+
+	lazperf_delete_vlr_decompressor(decompressor);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_record_schema(record_schema);
+	free(tiles[0]);
+	free(tiles[1]);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+struct CountingAllocator
+{
+	size_t num_allocations;
+	size_t num_frees;
+};
+
+static void *counting_malloc(void *ctx, size_t size)
+{
+	((struct CountingAllocator *) ctx)->num_allocations++;
+	return malloc(size);
+}
+
+static void *counting_realloc(void *ctx, void *ptr, size_t size)
+{
+	if (ptr == NULL)
+	{
+		((struct CountingAllocator *) ctx)->num_allocations++;
+	}
+	return realloc(ptr, size);
+}
+
+static void counting_free(void *ctx, void *ptr)
+{
+	((struct CountingAllocator *) ctx)->num_frees++;
+	free(ptr);
+}
+
+int test_allocator()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	struct CountingAllocator counts = {0, 0};
+	lazperf_set_allocator(counting_malloc, counting_realloc, counting_free, &counts);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	struct LazPerf_BufferResult compression_result = lazperf_compress_points(
+			record_schema, 0, uncompressed_points, POINT_COUNT);
+	assert(!compression_result.is_error);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+
+	struct LazPerf_BufferResult decompression_result = lazperf_decompress_points(
+			(const uint8_t *) compression_result.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+			compression_result.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+			laz_vlr_data.data,
+			POINT_COUNT,
+			34);
+	assert(!decompression_result.is_error);
+	assert(memcmp(decompression_result.points_buffer.data, uncompressed_points, 36210) == 0);
+
+	// Errors are allocated with the allocator too
+	struct LazPerf_BufferResult error_result = lazperf_decompress_points(
+			(const uint8_t *) compression_result.points_buffer.data, 0, laz_vlr_data.data, POINT_COUNT, 34);
+	assert(error_result.is_error);
+
+	lazperf_delete_result(&error_result);
+	lazperf_delete_result(&decompression_result);
+	lazperf_delete_result(&compression_result);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_record_schema(record_schema);
+	assert(counts.num_allocations > 0);
+	assert(counts.num_allocations == counts.num_frees);
+
+	lazperf_set_allocator(NULL, NULL, NULL, NULL);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_stats()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	struct LazPerf_Stats stats = lazperf_vlr_compressor_stats(compressor);
+	assert(stats.num_chunks == 0);
+	lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	struct LazPerf_VoidResult enable_result = lazperf_vlr_compressor_enable_stats(compressor, 1);
+	assert(!enable_result.is_error);
+
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	enable_result = lazperf_vlr_compressor_enable_stats(compressor, 0);
+	assert(enable_result.is_error);
+	lazperf_delete_void_result(&enable_result);
+	uint64_t compressed_size = lazperf_vlr_compressor_done(compressor);
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+
+	stats = lazperf_vlr_compressor_stats(compressor);
+	assert(stats.num_chunks == (POINT_COUNT + 99) / 100);
+	assert(stats.num_items == 3);
+	uint64_t num_points = 0;
+	uint64_t num_bytes = 0;
+	for (size_t i = 0; i < stats.num_chunks; ++i)
+	{
+		const struct LazPerf_ChunkStats *chunk = &stats.chunks[i];
+		assert(chunk->first_point == num_points);
+		assert(chunk->seconds >= chunk->model_reset_seconds);
+		assert(chunk->item_bytes[0] > 0 && chunk->item_bytes[1] > 0 && chunk->item_bytes[2] > 0);
+		num_points += chunk->point_count;
+		num_bytes += chunk->compressed_bytes;
+	}
+	assert(num_points == POINT_COUNT);
+	assert(num_bytes == compressed_size - SIZEOF_CHUNK_TABLE_OFFSET);
+
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+	LazPerf_VlrDecompressorPtr decompressor = lazperf_new_vlr_decompressor(
+			lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET,
+			lazperf_vlr_compressor_internal_buffer_size(compressor) - SIZEOF_CHUNK_TABLE_OFFSET,
+			34,
+			laz_vlr_data.data
+	);
+	enable_result = lazperf_vlr_decompressor_enable_stats(decompressor, 0);
+	assert(!enable_result.is_error);
+
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	struct LazPerf_VoidResult decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, 150, decompressed_points);
+	assert(!decomp_result.is_error);
+	stats = lazperf_vlr_decompressor_stats(decompressor);
+	assert(stats.num_chunks == 2);
+	assert(stats.num_items == 0);
+	assert(stats.chunks[1].first_point == 100 && stats.chunks[1].point_count == 50);
+
+	decomp_result = lazperf_vlr_decompressor_decompress_many(
+			decompressor, POINT_COUNT - 150, decompressed_points + 150 * 34);
+	assert(!decomp_result.is_error);
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+	stats = lazperf_vlr_decompressor_stats(decompressor);
+	assert(stats.num_chunks == (POINT_COUNT + 99) / 100);
+	num_points = 0;
+	for (size_t i = 0; i < stats.num_chunks; ++i)
+	{
+		assert(stats.chunks[i].compressed_bytes > 0);
+		num_points += stats.chunks[i].point_count;
+	}
+	assert(num_points == POINT_COUNT);
+	lazperf_delete_vlr_decompressor(decompressor);
+
+	// The items of every chunk are measured, the partial last one included, with or without the chunk table
+	for (int read_table = 0; read_table < 2; ++read_table)
+	{
+		decompressor = lazperf_new_vlr_decompressor(
+				lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET,
+				lazperf_vlr_compressor_internal_buffer_size(compressor) - SIZEOF_CHUNK_TABLE_OFFSET,
+				34,
+				laz_vlr_data.data
+		);
+		if (read_table)
+		{
+			struct LazPerf_VoidResult table_result = lazperf_vlr_decompressor_read_chunk_table(
+					decompressor, compressed_size - SIZEOF_CHUNK_TABLE_OFFSET, POINT_COUNT);
+			assert(!table_result.is_error);
+		}
+		enable_result = lazperf_vlr_decompressor_enable_stats(decompressor, 1);
+		assert(!enable_result.is_error);
+		decomp_result = lazperf_vlr_decompressor_decompress_many(decompressor, POINT_COUNT, decompressed_points);
+		assert(!decomp_result.is_error);
+		stats = lazperf_vlr_decompressor_stats(decompressor);
+		assert(stats.num_chunks == (POINT_COUNT + 99) / 100);
+		assert(stats.num_items == 3);
+		for (size_t i = 0; i < stats.num_chunks; ++i)
+		{
+			const struct LazPerf_ChunkStats *chunk = &stats.chunks[i];
+			assert(chunk->item_bytes[0] > 0 && chunk->item_bytes[1] > 0 && chunk->item_bytes[2] > 0);
+		}
+		lazperf_delete_vlr_decompressor(decompressor);
+	}
+
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_prefetching_decompression()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(record_schema);
+	lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	lazperf_vlr_compressor_compress_many(compressor, POINT_COUNT, uncompressed_points);
+	uint64_t chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(compressor);
+	const uint8_t *compressed_points = lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET;
+	size_t compressed_size = lazperf_vlr_compressor_internal_buffer_size(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+
+	struct LazPerf_PrefetchingDecompressorResult result = lazperf_new_prefetching_decompressor(
+			compressed_points, compressed_size, compressed_size, laz_vlr_data.data, POINT_COUNT, 34, 2, 3);
+	assert(result.is_error);
+	lazperf_delete_prefetching_decompressor_result(&result);
+
+	result = lazperf_new_prefetching_decompressor(
+			compressed_points, compressed_size, chunk_table_offset, laz_vlr_data.data, POINT_COUNT, 34, 2, 3);
+	assert(!result.is_error);
+
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	size_t num_points = 0;
+	size_t num_chunks = 0;
+	for (;;)
+	{
+		const char *points = NULL;
+		struct LazPerf_SizeResult chunk_result = lazperf_prefetching_decompressor_next_chunk(
+				result.decompressor, &points);
+		assert(!chunk_result.is_error);
+		if (chunk_result.size == 0)
+		{
+			break;
+		}
+		memcpy(decompressed_points + num_points * 34, points, chunk_result.size * 34);
+		num_points += chunk_result.size;
+		num_chunks++;
+	}
+	assert(num_points == POINT_COUNT);
+	assert(num_chunks == (POINT_COUNT + 99) / 100);
+	assert(memcmp(uncompressed_points, decompressed_points, 36210) == 0);
+	lazperf_delete_prefetching_decompressor(result.decompressor);
+
+	// Deleting the decompressor while its workers are still ahead of the consumer
+	result = lazperf_new_prefetching_decompressor(
+			compressed_points, compressed_size, chunk_table_offset, laz_vlr_data.data, POINT_COUNT, 34, 0, 0);
+	assert(!result.is_error);
+	const char *points = NULL;
+	struct LazPerf_SizeResult chunk_result = lazperf_prefetching_decompressor_next_chunk(result.decompressor, &points);
+	assert(!chunk_result.is_error && chunk_result.size == 100);
+	assert(memcmp(uncompressed_points, points, 100 * 34) == 0);
+	lazperf_delete_prefetching_decompressor(result.decompressor);
+
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_batch()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+
+	// The second job is split in chunks of 100 points
+	size_t job_points[3] = {POINT_COUNT, 500, 0};
+	uint32_t job_chunk_sizes[3] = {0, 100, 0};
+	struct LazPerf_CompressJob compress_jobs[3];
+	for (size_t i = 0; i < 3; ++i)
+	{
+		compress_jobs[i].schema = record_schema;
+		compress_jobs[i].offset_to_point_data = OFFSET_TO_POINT_DATA;
+		compress_jobs[i].points = uncompressed_points + (POINT_COUNT - job_points[i]) * 34;
+		compress_jobs[i].num_points = job_points[i];
+		compress_jobs[i].chunk_size = job_chunk_sizes[i];
+	}
+
+	struct LazPerf_BufferResult compress_results[3];
+	struct LazPerf_VoidResult result = lazperf_compress_batch(compress_jobs, 3, 4, compress_results);
+	assert(!result.is_error);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		struct LazPerf_BufferResult serial_result = lazperf_compress_points_parallel(
+				record_schema, OFFSET_TO_POINT_DATA, compress_jobs[i].points, job_points[i], job_chunk_sizes[i], 1);
+		assert(!compress_results[i].is_error && !serial_result.is_error);
+		assert(compress_results[i].points_buffer.size == serial_result.points_buffer.size);
+		assert(memcmp(compress_results[i].points_buffer.data, serial_result.points_buffer.data,
+					  serial_result.points_buffer.size) == 0);
+		lazperf_delete_result(&serial_result);
+	}
+
+	// The last job points to a chunk table that does not exist
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+	LazPerf_LazVlrPtr small_chunks_vlr = lazperf_new_laz_vlr_from_schema(record_schema);
+	struct LazPerf_VoidResult set_result = lazperf_laz_vlr_set_chunk_size(small_chunks_vlr, 100);
+	assert(!set_result.is_error);
+	char *small_chunks_vlr_data = malloc(lazperf_laz_vlr_record_data_size(small_chunks_vlr));
+	lazperf_laz_vlr_copy_record_data(small_chunks_vlr, small_chunks_vlr_data);
+	char *decompressed_points = malloc(3 * 36210 * sizeof(char));
+	struct LazPerf_DecompressJob decompress_jobs[3];
+	for (size_t i = 0; i < 3; ++i)
+	{
+		size_t source = i == 2 ? 0 : i;
+		decompress_jobs[i].compressed_points_buffer =
+				(uint8_t *) compress_results[source].points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET;
+		decompress_jobs[i].buffer_size = compress_results[source].points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET;
+		decompress_jobs[i].chunk_table_offset = lazperf_read_chunk_table_offset(
+				(uint8_t *) compress_results[source].points_buffer.data, OFFSET_TO_POINT_DATA);
+		decompress_jobs[i].laszip_vlr_data = source == 1 ? small_chunks_vlr_data : laz_vlr_data.data;
+		decompress_jobs[i].num_points = job_points[source];
+		decompress_jobs[i].point_size = 34;
+		decompress_jobs[i].out_buffer = (uint8_t *) decompressed_points + i * 36210;
+	}
+	decompress_jobs[2].chunk_table_offset = decompress_jobs[2].buffer_size;
+
+	struct LazPerf_VoidResult decompress_results[3];
+	result = lazperf_decompress_batch(decompress_jobs, 3, 4, decompress_results);
+	assert(result.is_error);
+	lazperf_delete_void_result(&result);
+	assert(!decompress_results[0].is_error && !decompress_results[1].is_error && decompress_results[2].is_error);
+	assert(memcmp(decompressed_points, uncompressed_points, 36210) == 0);
+	assert(memcmp(decompressed_points + 36210, compress_jobs[1].points, 500 * 34) == 0);
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		lazperf_delete_void_result(&decompress_results[i]);
+		lazperf_delete_result(&compress_results[i]);
+	}
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	free(small_chunks_vlr_data);
+	lazperf_delete_laz_vlr(small_chunks_vlr);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+int test_point_layouts()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	// point, point + gpstime, point + rgb, point + gpstime + rgb and point + gpstime + rgb + extra bytes,
+	// the last one going through the dynamic codec
+	int has_gpstime[5] = {0, 1, 0, 1, 1};
+	int has_rgb[5] = {0, 0, 1, 1, 1};
+	size_t num_extra_bytes[5] = {0, 0, 0, 0, 3};
+	char *points = malloc(POINT_COUNT * 37 * sizeof(char));
+	for (size_t layout = 0; layout < 5; ++layout)
+	{
+		LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+		lazperf_record_schema_push_point(record_schema);
+		if (has_gpstime[layout])
+		{
+			lazperf_record_schema_push_gpstime(record_schema);
+		}
+		if (has_rgb[layout])
+		{
+			lazperf_record_schema_push_rgb(record_schema);
+		}
+		if (num_extra_bytes[layout] != 0)
+		{
+			lazperf_record_schema_push_extrabytes(record_schema, num_extra_bytes[layout]);
+		}
+		size_t point_size = (size_t) lazperf_record_schema_size_in_bytes(record_schema);
+
+		char *point = points;
+		for (size_t i = 0; i < POINT_COUNT; ++i)
+		{
+			const char *source = uncompressed_points + i * 34;
+			memcpy(point, source, 20);
+			point += 20;
+			if (has_gpstime[layout])
+			{
+				memcpy(point, source + 20, 8);
+				point += 8;
+			}
+			if (has_rgb[layout])
+			{
+				memcpy(point, source + 28, 6);
+				point += 6;
+			}
+			for (size_t j = 0; j < num_extra_bytes[layout]; ++j)
+			{
+				*point++ = (char) (i + j);
+			}
+		}
+
+		struct LazPerf_BufferResult result = lazperf_compress_points(
+				record_schema, OFFSET_TO_POINT_DATA, points, POINT_COUNT);
+		assert(!result.is_error);
+
+		struct LazPerf_SizedBuffer laz_vlr_data = lazperf_record_schema_laz_vlr_data(record_schema);
+		struct LazPerf_BufferResult decomp_result = lazperf_decompress_points(
+				(uint8_t *) result.points_buffer.data + sizeof(uint64_t),
+				result.points_buffer.size - sizeof(uint64_t),
+				laz_vlr_data.data,
+				POINT_COUNT,
+				point_size
+		);
+		assert(!decomp_result.is_error);
+		assert(decomp_result.points_buffer.size == POINT_COUNT * point_size);
+		assert(memcmp(decomp_result.points_buffer.data, points, POINT_COUNT * point_size) == 0);
+
+		lazperf_delete_result(&decomp_result);
+		lazperf_delete_sized_buffer(laz_vlr_data);
+		lazperf_delete_result(&result);
+		lazperf_delete_record_schema(record_schema);
+	}
+
+	free(points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
+
+static LazPerf_VlrCompressorPtr compress_merge_input(
+		LazPerf_RecordSchemaPtr schema,
+		const char *points,
+		size_t num_points,
+		struct LazPerf_MergeInput *input)
+{
+	LazPerf_VlrCompressorPtr compressor = lazperf_new_vlr_compressor(schema);
+	lazperf_vlr_compressor_set_chunk_size(compressor, 100);
+	lazperf_vlr_compressor_compress_many(compressor, num_points, points);
+	input->chunk_table_offset = lazperf_vlr_compressor_done(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	lazperf_vlr_compressor_write_chunk_table(compressor);
+	input->compressed_points_buffer = lazperf_vlr_compressor_internal_buffer(compressor) + SIZEOF_CHUNK_TABLE_OFFSET;
+	input->buffer_size = lazperf_vlr_compressor_internal_buffer_size(compressor) - SIZEOF_CHUNK_TABLE_OFFSET;
+	input->num_points = num_points;
+	return compressor;
+}
+
+int test_merge()
+{
+	FILE *uncompressed_points_file = fopen("./tests/data/simple_points_uncompressed.bin", "rb");
+	if (uncompressed_points_file == NULL)
+	{
+		perror("fopen() of uncompressed points failed");
+		return EXIT_FAILURE;
+	}
+
+	char *uncompressed_points = malloc(36210 * sizeof(char));
+	fread(uncompressed_points, sizeof(char), 36210, uncompressed_points_file);
+	fclose(uncompressed_points_file);
+
+	LazPerf_RecordSchemaPtr record_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(record_schema);
+	lazperf_record_schema_push_gpstime(record_schema);
+	lazperf_record_schema_push_rgb(record_schema);
+	LazPerf_VlrCompressorPtr vlr_compressor = lazperf_new_vlr_compressor(record_schema);
+	lazperf_vlr_compressor_set_chunk_size(vlr_compressor, 100);
+	struct LazPerf_SizedBuffer laz_vlr_data = lazperf_vlr_compressor_vlr_data(vlr_compressor);
+
+	struct LazPerf_MergeInput whole_input;
+	LazPerf_VlrCompressorPtr whole = compress_merge_input(
+			record_schema, uncompressed_points, POINT_COUNT, &whole_input);
+
+	// When all the chunks but the last one are full, the chunk size is kept and the merged points
+	// are the same as the points compressed at once, otherwise the chunks become variable
+	size_t splits[2][3] = {{400, 400, 265}, {450, 400, 215}};
+	char *decompressed_points = malloc(36210 * sizeof(char));
+	for (size_t split = 0; split < 2; ++split)
+	{
+		LazPerf_VlrCompressorPtr compressors[3];
+		struct LazPerf_MergeInput inputs[3];
+		const char *points = uncompressed_points;
+		for (size_t i = 0; i < 3; ++i)
+		{
+			compressors[i] = compress_merge_input(record_schema, points, splits[split][i], &inputs[i]);
+			inputs[i].laszip_vlr_data = laz_vlr_data.data;
+			points += splits[split][i] * 34;
+		}
+
+		struct LazPerf_MergeResult result = lazperf_merge_points(inputs, 3, OFFSET_TO_POINT_DATA);
+		assert(!result.is_error);
+		assert(result.merged.laszip_vlr_data.size == laz_vlr_data.size);
+		uint32_t chunk_size;
+		memcpy(&chunk_size, result.merged.laszip_vlr_data.data + 12, sizeof(uint32_t));
+		assert(chunk_size == (split == 0 ? 100 : UINT32_MAX));
+		if (split == 0)
+		{
+			assert(result.merged.points_buffer.size == whole_input.buffer_size + SIZEOF_CHUNK_TABLE_OFFSET);
+			assert(memcmp(result.merged.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+						  whole_input.compressed_points_buffer, whole_input.buffer_size) == 0);
+		}
+
+		struct LazPerf_VoidResult decomp_result = lazperf_decompress_points_parallel(
+				(uint8_t *) result.merged.points_buffer.data + SIZEOF_CHUNK_TABLE_OFFSET,
+				result.merged.points_buffer.size - SIZEOF_CHUNK_TABLE_OFFSET,
+				lazperf_read_chunk_table_offset((uint8_t *) result.merged.points_buffer.data, OFFSET_TO_POINT_DATA),
+				result.merged.laszip_vlr_data.data,
+				POINT_COUNT,
+				34,
+				(uint8_t *) decompressed_points,
+				2
+		);
+		assert(!decomp_result.is_error);
+		assert(memcmp(decompressed_points, uncompressed_points, 36210) == 0);
+
+		lazperf_delete_merge_result(&result);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			lazperf_delete_vlr_compressor(compressors[i]);
+		}
+	}
+
+	// Points with another schema cannot be merged
+	LazPerf_RecordSchemaPtr other_schema = lazperf_new_record_schema();
+	lazperf_record_schema_push_point(other_schema);
+	struct LazPerf_SizedBuffer other_vlr_data = lazperf_record_schema_laz_vlr_data(other_schema);
+	struct LazPerf_MergeInput inputs[2] = {whole_input, whole_input};
+	inputs[0].laszip_vlr_data = laz_vlr_data.data;
+	inputs[1].laszip_vlr_data = other_vlr_data.data;
+	struct LazPerf_MergeResult result = lazperf_merge_points(inputs, 2, OFFSET_TO_POINT_DATA);
+	assert(result.is_error);
+	lazperf_delete_merge_result(&result);
+
+	lazperf_delete_sized_buffer(other_vlr_data);
+	lazperf_delete_record_schema(other_schema);
+	lazperf_delete_vlr_compressor(whole);
+	lazperf_delete_sized_buffer(laz_vlr_data);
+	lazperf_delete_vlr_compressor(vlr_compressor);
+	lazperf_delete_record_schema(record_schema);
+	free(decompressed_points);
+	free(uncompressed_points);
+	return EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[])
 {
@@ -364,6 +2336,28 @@ int main(int argc, char *argv[])
 	test_streaming_compression();
 	test_record_schema();
 	test_laz_vlr();
+	test_parallel_decompression();
+	test_parallel_compression();
+	test_read_chunk_table();
+	test_seek();
+	test_batched_compression_decompression();
+	test_compression_into();
+	test_sink_compression();
+	test_source_decompression();
+	test_file_reader();
+	test_file_writer();
+	test_columnar_decompression();
+	test_query_box();
+	test_chunk_index();
+	test_variable_chunks();
+	test_chunk_size();
+	test_decompressor_reset();
+	test_allocator();
+	test_stats();
+	test_prefetching_decompression();
+	test_batch();
+	test_point_layouts();
+	test_merge();
 	return EXIT_SUCCESS;
 }
 